@@ -0,0 +1,102 @@
+#include "AllocationAudit.h"
+#include "App.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+constexpr std::size_t WARMUP_FRAMES = 10;
+constexpr std::size_t STEADY_FRAMES = 120;
+
+struct Step
+{
+	const char* name;
+	void (*enter)(App& app);
+};
+
+const Step STEPS[] =
+{
+	{"main menu", [](App& app) { app.submitCommand<SwapUI>(SwapUI::DEFAULT<MainMenu>); }},
+	{"play menu", [](App& app) { app.submitCommand<SwapUI>([&game = app.getGame()](AppUI& ui) { ui.emplace<PlayMenu>(game); }); }},
+	{"custom menu", [](App& app) { app.submitCommand<SwapUI>([&game = app.getGame()](AppUI& ui) { ui.emplace<CustomMenu>(game); }); }},
+	{"settings menu", [](App& app) { app.submitCommand<SwapUI>(SwapUI::DEFAULT<SettingsMenu>); }},
+	{"new game", [](App& app)
+		{
+			app.getGame().setHard();
+			app.getGame().restart();
+			app.submitCommand<SwapUI>([&app](AppUI& ui) { ui.emplace<GameUI>(app); });
+		}},
+	{"game in progress", [](App& app)
+		{
+			Vec2s size = app.getGame().getSnapshot().size;
+			app.getGame().open({size.x / 2, size.y / 2});
+			app.getGame().flag({0, 0});
+		}},
+};
+
+constexpr std::size_t STEP_COUNT = std::size(STEPS);
+static_assert(STEP_COUNT <= 32, "One bit per step in failedSteps_");
+
+} // namespace
+
+AllocationAudit::AllocationAudit()
+	: step_(0)
+	, frame_(0)
+	, steadyFrames_(0)
+	, failedFrames_(0)
+	, allocations_{}
+	, failedSteps_(0)
+{}
+
+bool AllocationAudit::step(App& app, const FrameProfiler::Allocations& allocations)
+{
+	if (step_ == STEP_COUNT)
+		return false;
+
+	if (frame_ == 0)
+		STEPS[step_].enter(app);
+
+	if (frame_ >= WARMUP_FRAMES)
+	{
+		++steadyFrames_;
+		if (allocations[FrameProfiler::Frame])
+		{
+			++failedFrames_;
+			failedSteps_ |= 1u << step_;
+			for (std::size_t stage = 0; stage < FrameProfiler::StageCount; ++stage)
+				allocations_[stage] += allocations[stage];
+		}
+	}
+
+	if (++frame_ == WARMUP_FRAMES + STEADY_FRAMES)
+	{
+		frame_ = 0;
+		++step_;
+	}
+	return step_ < STEP_COUNT;
+}
+
+int AllocationAudit::report() const
+{
+	if (!AllocationTracker::ENABLED)
+	{
+		std::fprintf(stderr, "Allocation audit: built without MPP_TRACK_ALLOCATIONS, nothing was counted\n");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("Allocation audit: %ju of %zu steady frames allocated\n", std::uintmax_t(failedFrames_), steadyFrames_);
+	if (!failedFrames_)
+		return EXIT_SUCCESS;
+
+	for (std::size_t step = 0; step < STEP_COUNT; ++step)
+		if (failedSteps_ & (1u << step))
+			std::printf("  in %s\n", STEPS[step].name);
+	for (std::size_t stage = 0; stage < FrameProfiler::StageCount; ++stage)
+		if (allocations_[stage])
+		{
+			auto name = FrameProfiler::getStageName(FrameProfiler::Stage(stage));
+			std::printf("  %-12.*s %ju allocations\n", int(name.size()), name.data(), std::uintmax_t(allocations_[stage]));
+		}
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "FrameProfiler.h"
+#include <cstddef>
+#include <cstdint>
+
+class App;
+
+/*
+ * Scripted session checking that steady frames do not allocate.
+ *
+ * It walks through every menu, then a game before and after its first click,
+ * holding each screen for a number of frames. The first frames after a change
+ * may allocate (a new menu, a new board), the following ones must not.
+ * Needs MPP_TRACK_ALLOCATIONS, nothing is counted otherwise.
+ */
+class AllocationAudit
+{
+public:
+
+	AllocationAudit();
+
+	// After each frame. Returns false once the script is over.
+	bool step(App& app, const FrameProfiler::Allocations& allocations);
+
+	// Prints the offending screens and stages, EXIT_FAILURE if there was any.
+	int report() const;
+
+private:
+
+	std::size_t step_;
+	std::size_t frame_; // since the step began
+	std::size_t steadyFrames_;
+	std::uint64_t failedFrames_;
+	FrameProfiler::Allocations allocations_; // by steady frames, per stage
+	std::uint32_t failedSteps_; // bit per step
+};
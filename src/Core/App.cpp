@@ -2,10 +2,14 @@
 #include "Game/Resources.h"
 #include "UI/UITarget.h"
 #include "Utils/Overloaded.h"
+#include "Utils/Trace.h"
 #include <SFML/Graphics/RenderTexture.hpp>
+#include <algorithm>
+#include <cassert>
 #include <chrono>
 #include <cstdlib>
 #include <cmath>
+#include <format>
 
 namespace
 {
@@ -16,6 +20,18 @@ sf::Vector2u getDefaultWindowSize()
 	return sf::Vector2u(sf::Vector2f(screenSize) * 0.75f);
 }
 
+// Below the game texts in the top left corner, click latencies on the right
+constexpr sf::Vector2i PROFILER_POSITION = {5, 100};
+constexpr sf::Vector2i INPUT_LATENCY_POSITION = {445, 100};
+
+// Animations run at a fixed rate, whatever the frame rate. A frame slower
+// than the steps it may run slows them down.
+constexpr std::chrono::nanoseconds ANIMATION_STEP{1'000'000'000 / 120};
+constexpr int MAX_ANIMATION_STEPS = 8;
+
+// How long commands from background work can wait while no input comes
+const sf::Time COMMAND_POLL_INTERVAL = sf::milliseconds(16);
+
 sf::ContextSettings getDefaultContextSettings()
 {
 	return sf::ContextSettings
@@ -30,9 +46,29 @@ App::App()
 	: window_(sf::VideoMode(getDefaultWindowSize()), "Mine++", sf::State::Windowed, getDefaultContextSettings())
 	, clearColor_({0x31, 0x4D, 0x79, 0x00})
 	, isMouseDraggingCamera_(false)
+	, redraw_(true)
+	, animationClock_(ANIMATION_STEP, MAX_ANIMATION_STEPS)
+	, commandLatencies_{}
+	, rejectedCommands_(0)
 {
 	window_.setVerticalSyncEnabled(true);
+	game_.setJobSystem(&jobs_);
 	std::visit([&](auto& ui) { ui(UIEvent::Resized{*this, sf::Vector2i(window_.getSize())}); }, ui_);
+
+	// Straight back into the game the previous run left unfinished
+	if (game_.recoverAutosave())
+	{
+		submitCommand<SwapUI>([this](AppUI& ui) { ui.emplace<GameUI>(*this); });
+		submitCommand<ChangeClearColor>(sf::Color{0x79, 0x31, 0x32, 0x00});
+	}
+}
+
+App::~App()
+{
+	// Jobs still running are only waited for once the command queue is gone:
+	// what they finish from now on is dropped
+	std::lock_guard lock(continuations_.mutex);
+	continuations_.open = false;
 }
 
 int App::run()
@@ -40,36 +76,107 @@ int App::run()
 	auto lastFrame = std::chrono::steady_clock::now();
 	while (window_.isOpen())
 	{
-		pollEvents();
+		MPP_TRACE_SCOPE("frame");
+		profiler_.beginFrame();
+
+		// Time spent idle, waiting for input, is not animated
+		bool animating = isAnimating();
+		{
+			FrameProfiler::Scope scope(profiler_, FrameProfiler::PollEvents);
+			MPP_TRACE_SCOPE("pollEvents");
+			pollEvents();
+		}
 
 		auto now = std::chrono::steady_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastFrame).count() / 1e9f;
+		auto elapsed = animating ? std::chrono::nanoseconds(now - lastFrame) : std::chrono::nanoseconds::zero();
 		lastFrame = now;
-		game_.update(dt);
-
-		window_.clear(clearColor_);
 		{
-			game_.render(window_);
+			FrameProfiler::Scope scope(profiler_, FrameProfiler::GameUpdate);
+			MPP_TRACE_SCOPE("update");
+			for (int steps = animationClock_.advance(elapsed); steps > 0; --steps)
+				game_.step(animationClock_.getStepSeconds());
+			if (game_.update(animationClock_.getAlpha()))
+				redraw_ = true; // the last snapshot comes once nothing animates anymore
+			GameControls::play(audio_, game_.takeFeedback());
+		}
+		profiler_.add(FrameProfiler::BoardEncode, game_.getRendererTimings().encode);
+		profiler_.add(FrameProfiler::BoardUpload, game_.getRendererTimings().upload);
 
-			UITarget uiTarget(window_);
-			Overloaded visitor
+		// Frames are only drawn when something changed, vsync paces the animations
+		if (redraw_ || isAnimating())
+		{
+			redraw_ = false;
+			{
+				FrameProfiler::Scope scope(profiler_, FrameProfiler::GameRender);
+				MPP_TRACE_SCOPE("render");
+				window_.clear(clearColor_);
+				game_.render(window_);
+			}
 			{
-				[](std::monostate&) {},
-				[&](auto& ui) { ui.render(uiTarget); }
-			};
-			std::visit(visitor, ui_);
+				FrameProfiler::Scope scope(profiler_, FrameProfiler::UIRender);
+				MPP_TRACE_SCOPE("ui");
+				UITarget uiTarget(window_);
+				Overloaded visitor
+				{
+					[](std::monostate&) {},
+					[&](auto& ui) { ui.render(uiTarget); }
+				};
+				std::visit(visitor, ui_);
+
+				if (profiler_.isEnabled())
+				{
+					const auto& counters = game_.getSnapshot().counters;
+					CommandStats commandStats = getCommandStats();
+					CommandStats::Latency commands{};
+					for (const CommandStats::Latency& latency : commandStats.byType)
+					{
+						commands.count += latency.count;
+						commands.max = std::max(commands.max, latency.max);
+					}
+
+					std::array<char, 320> notes;
+					auto result = std::format_to_n(notes.data(), notes.size(),
+						"opens {}: {} cells, {} max\n"
+						"seed stack: {} peak, {} spills\n"
+						"scan pushes {}\n"
+						"mine moves {} / {} failed, {} safe\n"
+						"commands {}: {:.2f} ms max wait, {} rejected",
+						counters.openCalls, counters.cellsOpened, counters.maxCellsPerOpen,
+						counters.seedStackPeak, counters.seedStackSpills,
+						counters.scanRowPushes,
+						counters.moveMineSuccesses, counters.moveMineFailures, counters.makeSafeRelocations,
+						commands.count, double(commands.max.count()) / 1e6, commandStats.rejected);
+					profiler_.render(uiTarget, PROFILER_POSITION, {notes.data(), std::size_t(result.out - notes.data())});
+					inputLatency_.render(uiTarget, INPUT_LATENCY_POSITION);
+				}
+			}
+			{
+				FrameProfiler::Scope scope(profiler_, FrameProfiler::Display);
+				MPP_TRACE_SCOPE("display");
+				window_.display();
+			}
+			if (auto uploaded = game_.takeUploadedClick())
+				inputLatency_.add(uploaded->click.input, uploaded->click.applied, uploaded->uploaded, std::chrono::steady_clock::now());
 		}
-		window_.display();
 
-		processCommands();
+		{
+			FrameProfiler::Scope scope(profiler_, FrameProfiler::ProcessCommands);
+			MPP_TRACE_SCOPE("processCommands");
+			processCommands();
+		}
+		profiler_.endFrame();
+
+		if (audit_ && !audit_->step(*this, profiler_.getFrameAllocations()))
+			window_.close();
 	}
 
-	return EXIT_SUCCESS;
+	return audit_ ? audit_->report() : EXIT_SUCCESS;
 }
 
 void App::resetView()
 {
 	window_.setView(window_.getDefaultView());
+	redraw_ = true;
 }
 
 void App::centerView(sf::FloatRect target)
@@ -94,10 +201,14 @@ void App::centerView(sf::FloatRect target)
 	view.setCenter(target.getCenter());
 	view.setSize(viewSize);
 	window_.setView(view);
+	redraw_ = true;
 }
 
 void App::pollEvents()
 {
+	// SFML only hands events out on the window thread, in the order they came:
+	// they are timed as they are taken, the closest to their arrival there is.
+	std::chrono::steady_clock::time_point eventTime;
 	Overloaded visitor
 	{
 		[&](const sf::Event::Closed& event)
@@ -147,7 +258,7 @@ void App::pollEvents()
 			if (result == UIEvent::Ignored)
 			{
 				sf::Vector2f position = window_.mapPixelToCoords(event.position);
-				game_.dispatchWorldEvent(WorldEvent::Released{*this, event.button, position});
+				game_.dispatchWorldEvent(WorldEvent::Released{*this, event.button, position, eventTime});
 			}
 			else
 			{
@@ -188,11 +299,46 @@ void App::pollEvents()
 			std::visit([&](auto& ui) { ui(UIEvent::Typed{*this, event.unicode}); }, ui_);
 		},
 
+		[&](const sf::Event::KeyPressed& event)
+		{
+			if (event.code == sf::Keyboard::Key::F3)
+			{
+				profiler_.setEnabled(!profiler_.isEnabled());
+				game_.setProfiling(profiler_.isEnabled());
+				inputLatency_.reset();
+			}
+		},
+
 		[](const auto& ignored) {}
 	};
 
-	while (auto event = window_.pollEvent())
+	// Nothing to draw: sleep until the next input, or the next tick of the timer
+	std::optional<sf::Event> event;
+	if (redraw_ || isAnimating())
+	{
+		event = window_.pollEvent();
+	}
+	else
+	{
+		auto tick = game_.getTimeToNextTick();
+		sf::Time wait = tick.value_or(sf::Time::Zero); // zero waits forever
+
+		// Background work may submit commands at any time
+		bool polling = continuations_.producers.load(std::memory_order_relaxed) > 0
+		               && (wait == sf::Time::Zero || COMMAND_POLL_INTERVAL < wait);
+		if (polling)
+			wait = COMMAND_POLL_INTERVAL;
+
+		event = window_.waitEvent(wait);
+		redraw_ = !event && !polling; // timed out on a tick
+	}
+
+	for (; event; event = window_.pollEvent())
+	{
+		eventTime = std::chrono::steady_clock::now();
 		event->visit(visitor);
+		redraw_ = true;
+	}
 }
 
 void App::processCommands()
@@ -214,6 +360,11 @@ void App::processCommands()
 			clearColor_ = cmd.color;
 		},
 
+		[&](RunOnMain& cmd)
+		{
+			cmd.task(*this);
+		},
+
 		[&](SwapUI& cmd)
 		{
 			resetView();
@@ -222,12 +373,50 @@ void App::processCommands()
 		}
 	};
 
-	for (auto& command : commands_)
+	// A lap of the queue at most: commands submitted by these ones, or by
+	// producers going faster than the frames, wait for the next frame
+	QueuedCommand queued;
+	for (std::size_t n = 0; n < COMMAND_QUEUE_CAPACITY && commands_.tryPop(queued); ++n)
 	{
-		if (command.index() == 0)
-			break;
+		auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(CommandClock::now() - queued.submitted);
+		CommandStats::Latency& latency = commandLatencies_[queued.command.index()];
+		++latency.count;
+		latency.total += waited;
+		latency.max = std::max(latency.max, waited);
+
+		std::visit(visitor, queued.command);
+		redraw_ = true;
+	}
 
-		std::visit(visitor, command);
-		command.emplace<0>();
+	// Then those that found the queue full, in the order they came
+	{
+		std::lock_guard lock(continuations_.mutex);
+		resumed_.swap(continuations_.parked);
 	}
+	for (RunOnMain& continuation : resumed_)
+	{
+		continuation.task(*this);
+		redraw_ = true;
+	}
+	resumed_.clear();
+}
+
+void App::resume(RunOnMain&& continuation)
+{
+	// Under the lock: the destructor cannot close in between, the queue is
+	// still there
+	std::lock_guard lock(continuations_.mutex);
+	if (!continuations_.open)
+		return;
+	if (!commands_.tryPush(std::move(continuation), CommandClock::now()))
+		continuations_.parked.push_back(std::move(continuation));
+}
+
+App::CommandStats App::getCommandStats() const
+{
+	return
+	{
+		.byType = commandLatencies_,
+		.rejected = rejectedCommands_.load(std::memory_order_relaxed)
+	};
 }
@@ -1,40 +1,95 @@
 #pragma once
+#include "AllocationAudit.h"
 #include "AppCommands.h"
 #include "Audio.h"
+#include "FrameProfiler.h"
+#include "InputLatency.h"
 #include "Game/Minesweeper.h"
 #include "Utils/NotCopyable.h"
+#include "Utils/FixedTimestep.h"
+#include "Utils/JobSystem.h"
+#include "Utils/MpscQueue.h"
 #include "Utils/NotMovable.h"
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <array>
-#include <cassert>
-#include <exception>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 class App : NotCopyable, NotMovable
 {
 public:
 
 	App();
+	~App(); // continuations still to come are dropped
 	int run();
 
+	// Plays the allocation audit script instead of waiting for input, run then
+	// returns its result.
+	void auditAllocations() { audit_.emplace(); }
+
 public:
 
 	Minesweeper& getGame() { return game_; }
 	Audio& getAudio() { return audio_; }
+	JobSystem& getJobs() { return jobs_; }
+
+	// Runs 'work' on the job system, then 'then' with its result on the main
+	// thread, at the end of the frame that sees it done. Never dropped while
+	// the app runs, even with the command queue full.
+	template <class Work, class Then>
+	void runInBackground(Work work, Then then);
 
 public:
 
-	// Defer execution until end of frame
+	// Defer execution until end of frame. Any thread can submit: background work
+	// hands its results over to the frame loop this way. Returns false if the
+	// queue is full, the command is then dropped and counted as rejected.
 	template <ValidCommand T, class... Args>
-	T& submitCommand(Args&&... args)
+	bool submitCommand(Args&&... args)
 	{
-		for (auto& command : commands_)
-			if (command.index() == 0)
-				return command.emplace<T>(std::forward<Args>(args)...);
-
-		assert(false && "Command queue is too small");
-		std::terminate();
+		if (commands_.tryPush(AppCommand(std::in_place_type<T>, std::forward<Args>(args)...), CommandClock::now()))
+			return true;
+		rejectedCommands_.fetch_add(1, std::memory_order_relaxed);
+		return false;
 	}
 
+	// Held by background work while it may submit commands, until they have
+	// run: runInBackground hands its own over to the continuation. As long as
+	// one is alive, the frame loop does not sleep until the next input but
+	// checks the queue a few times per second.
+	class CommandProducer : NotCopyable
+	{
+	public:
+
+		explicit CommandProducer(App& app) : producers_(&app.continuations_.producers) { producers_->fetch_add(1, std::memory_order_relaxed); }
+		CommandProducer(CommandProducer&& other) noexcept : producers_(std::exchange(other.producers_, nullptr)) {}
+		~CommandProducer() { if (producers_) producers_->fetch_sub(1, std::memory_order_relaxed); }
+
+	private:
+
+		std::atomic<int>* producers_;
+	};
+
+	// Time commands waited in the queue, by type. Main thread only.
+	struct CommandStats
+	{
+		struct Latency
+		{
+			std::uint64_t count;
+			std::chrono::nanoseconds total, max;
+		};
+		std::array<Latency, std::variant_size_v<AppCommand>> byType;
+		std::uint64_t rejected; // submitted to a full queue
+	};
+	CommandStats getCommandStats() const;
+
 public:
 
 	void resetView();
@@ -44,14 +99,64 @@ private:
 
 	void pollEvents();
 	void processCommands();
+	// Any thread. Parked if the queue is full, dropped once the app is closing.
+	void resume(RunOnMain&& continuation);
+	// Frames are drawn back to back, not only on changes
+	bool isAnimating() const { return game_.isAnimating() || profiler_.isEnabled() || audit_.has_value(); }
 
 private:
 
 	sf::RenderWindow window_;
 	sf::Color clearColor_;
 	bool isMouseDraggingCamera_;
+	bool redraw_; // something changed since the last frame
+	FixedTimestep animationClock_;
+	// Before the jobs, which hand their continuations over through it:
+	// destroyed after them
+	struct Continuations
+	{
+		std::mutex mutex;
+		bool open = true; // closed by the destructor
+		std::vector<RunOnMain> parked; // came while the command queue was full
+		std::atomic<int> producers = 0; // CommandProducers alive, those of jobs dropped at shutdown too
+	};
+	Continuations continuations_;
+	std::vector<RunOnMain> resumed_; // parked ones being run, kept for the capacity
+	// Before the game, which places mines on it: destroyed after it
+	JobSystem jobs_;
 	Minesweeper game_;
 	AppUI ui_;
 	Audio audio_;
-	std::array<AppCommand, 2> commands_;
+
+	using CommandClock = std::chrono::steady_clock;
+	struct QueuedCommand
+	{
+		AppCommand command;
+		CommandClock::time_point submitted;
+	};
+	static constexpr std::size_t COMMAND_QUEUE_CAPACITY = 64;
+	MpscQueue<QueuedCommand, COMMAND_QUEUE_CAPACITY> commands_;
+	std::array<CommandStats::Latency, std::variant_size_v<AppCommand>> commandLatencies_;
+	std::atomic<std::uint64_t> rejectedCommands_;
+
+	FrameProfiler profiler_;
+	InputLatency inputLatency_; // since the overlay was shown
+	std::optional<AllocationAudit> audit_;
 };
+
+template <class Work, class Then>
+void App::runInBackground(Work work, Then then)
+{
+	// Boxed: whatever it captures, the job and its continuation hold a pointer
+	struct Task
+	{
+		Work work;
+		Then then;
+		std::optional<std::invoke_result_t<Work&>> result;
+	};
+	jobs_.submit([this, producer = CommandProducer(*this), task = std::make_unique<Task>(std::move(work), std::move(then))]() mutable
+	{
+		task->result.emplace(task->work());
+		resume(RunOnMain{[producer = std::move(producer), task = std::move(task)](App&) mutable { task->then(std::move(*task->result)); }});
+	});
+}
@@ -1,10 +1,13 @@
 #pragma once
 #include "AppUI.h"
+#include "Utils/InplaceFunction.h"
 #include <SFML/Graphics/Color.hpp>
 #include <concepts>
-#include <functional>
+#include <utility>
 #include <variant>
 
+class App;
+
 struct RequestExit {};
 
 struct ChangeClearColor
@@ -12,19 +15,26 @@ struct ChangeClearColor
 	sf::Color color;
 };
 
+// Continuation of background work, back on the main thread
+struct RunOnMain
+{
+	InplaceFunction<void(App&)> task;
+};
+
 struct SwapUI
 {
 	template <class T>
 	static inline auto DEFAULT = [](AppUI& ui) { ui.emplace<T>(); };
 
-	std::function<void(AppUI &)> swapper;
+	InplaceFunction<void(AppUI&)> swapper; // stored inline: submitting a command never allocates
 };
 
 using AppCommand = std::variant<
 	std::monostate,
 	RequestExit,
 	ChangeClearColor,
+	RunOnMain,
 	SwapUI>;
 
 template <class T>
-concept ValidCommand = !std::same_as<T, std::monostate> && requires(T t) { AppCommand{t}; };
+concept ValidCommand = !std::same_as<T, std::monostate> && requires(T t) { AppCommand{std::move(t)}; };
@@ -1,5 +1,6 @@
 #pragma once
 #include <SFML/Window/Event.hpp>
+#include <chrono>
 #include <variant>
 
 struct AppEvent
@@ -65,6 +66,7 @@ struct WorldEvent
 	{
 		sf::Mouse::Button button;
 		sf::Vector2f position;
+		std::chrono::steady_clock::time_point time; // taken from the window
 	};
 
 	void visit(auto& visitor) const
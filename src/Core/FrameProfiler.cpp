@@ -0,0 +1,186 @@
+#include "FrameProfiler.h"
+#include "UI/Graph.h"
+#include "UI/Text.h"
+#include "UI/UITarget.h"
+#include <algorithm>
+#include <format>
+
+namespace
+{
+
+constexpr std::string_view STAGE_NAMES[FrameProfiler::StageCount] =
+{
+	"pollEvents",
+	"game update",
+	"  encode",
+	"  upload",
+	"game render",
+	"ui render",
+	"display",
+	"commands",
+	"frame",
+};
+
+constexpr int LINE_HEIGHT = 24;
+constexpr int NAME_WIDTH = 140;
+constexpr int COLUMN_WIDTH = 70;
+constexpr int GRAPH_HEIGHT = 60;
+constexpr float GRAPH_MAX_MS = 50.f;
+constexpr float FRAME_BUDGET_MS = 1000.f / 60.f;
+
+float toMilliseconds(std::chrono::nanoseconds time)
+{
+	return float(time.count()) / 1e6f;
+}
+
+// Stages are the allocation tags
+static_assert(FrameProfiler::StageCount <= AllocationTracker::UNTAGGED);
+
+} // namespace
+
+std::string_view FrameProfiler::getStageName(Stage stage)
+{
+	return STAGE_NAMES[stage];
+}
+
+FrameProfiler::FrameProfiler()
+	: enabled_(false)
+	, inFrame_(false)
+	, current_{}
+	, samples_{}
+	, next_(0)
+	, count_(0)
+	, allocationsAtStart_{}
+	, allocations_{}
+	, sorted_{}
+	, frameTimes_{}
+{}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+	enabled_ = enabled;
+	inFrame_ = false;
+	next_ = count_ = 0;
+}
+
+void FrameProfiler::beginFrame()
+{
+	if constexpr (AllocationTracker::ENABLED)
+	{
+		for (std::size_t tag = 0; tag < allocationsAtStart_.size(); ++tag)
+			allocationsAtStart_[tag] = AllocationTracker::get(std::uint8_t(tag)).allocations;
+	}
+
+	inFrame_ = enabled_;
+	if (!inFrame_)
+		return;
+
+	current_ = {};
+	frameStart_ = std::chrono::steady_clock::now();
+}
+
+void FrameProfiler::add(Stage stage, std::chrono::nanoseconds time)
+{
+	if (inFrame_)
+		current_[stage] += toMilliseconds(time);
+}
+
+void FrameProfiler::endFrame()
+{
+	if constexpr (AllocationTracker::ENABLED)
+	{
+		allocations_[Frame] = 0;
+		for (std::size_t tag = 0; tag < allocationsAtStart_.size(); ++tag)
+		{
+			std::uint64_t count = AllocationTracker::get(std::uint8_t(tag)).allocations - allocationsAtStart_[tag];
+			if (tag < Frame)
+				allocations_[tag] = count;
+			allocations_[Frame] += count; // untagged ones too
+		}
+	}
+
+	if (!inFrame_)
+		return;
+
+	current_[Frame] = toMilliseconds(std::chrono::steady_clock::now() - frameStart_);
+	samples_[next_] = current_;
+	next_ = (next_ + 1) % SAMPLE_COUNT;
+	count_ = std::min(count_ + 1, SAMPLE_COUNT);
+	inFrame_ = false;
+}
+
+FrameProfiler::Summary FrameProfiler::summarize(Stage stage) const
+{
+	if (count_ == 0)
+		return {};
+
+	float sum = 0.f;
+	for (std::size_t i = 0; i < count_; ++i)
+	{
+		sorted_[i] = samples_[i][stage];
+		sum += sorted_[i];
+	}
+
+	auto begin = sorted_.begin(), end = begin + std::ptrdiff_t(count_);
+	auto p99 = begin + std::ptrdiff_t((count_ * 99 + 99) / 100 - 1);
+	std::nth_element(begin, p99, end);
+	return {*std::min_element(begin, end), sum / float(count_), *p99};
+}
+
+void FrameProfiler::render(UITarget& target, sf::Vector2i position, std::string_view notes) const
+{
+	// Text is turned into vertices as it is drawn, the strings can live on the stack
+	auto print = [&](sf::Vector2i at, Text::Origin origin, std::string_view string)
+	{
+		target.draw(Text{.position = at, .origin = origin, .string = string});
+	};
+	auto printNumber = [&](sf::Vector2i at, float value)
+	{
+		std::array<char, 16> chars;
+		auto result = std::format_to_n(chars.data(), chars.size(), "{:.2f}", value);
+		print(at, Text::TopRight, {chars.data(), std::size_t(result.out - chars.data())});
+	};
+	auto column = [&](int i) { return position + sf::Vector2i(NAME_WIDTH + COLUMN_WIDTH * i, 0); };
+
+	std::array<char, 32> title;
+	auto result = std::format_to_n(title.data(), title.size(), "F3 - {} frames", count_);
+	print(position, Text::TopLeft, {title.data(), std::size_t(result.out - title.data())});
+	print(column(1), Text::TopRight, "min");
+	print(column(2), Text::TopRight, "avg");
+	print(column(3), Text::TopRight, "p99");
+	if constexpr (AllocationTracker::ENABLED)
+		print(column(4), Text::TopRight, "alloc");
+
+	for (std::size_t stage = 0; stage < StageCount; ++stage)
+	{
+		sf::Vector2i line = {0, LINE_HEIGHT * int(stage + 1)};
+		Summary summary = summarize(Stage(stage));
+		print(position + line, Text::TopLeft, STAGE_NAMES[stage]);
+		printNumber(column(1) + line, summary.min);
+		printNumber(column(2) + line, summary.avg);
+		printNumber(column(3) + line, summary.p99);
+		if constexpr (AllocationTracker::ENABLED)
+		{
+			std::array<char, 24> chars;
+			auto count = std::format_to_n(chars.data(), chars.size(), "{}", allocations_[stage]);
+			print(column(4) + line, Text::TopRight, {chars.data(), std::size_t(count.out - chars.data())});
+		}
+	}
+
+	// Oldest frame first
+	std::size_t oldest = (next_ + SAMPLE_COUNT - count_) % SAMPLE_COUNT;
+	for (std::size_t i = 0; i < count_; ++i)
+		frameTimes_[i] = samples_[(oldest + i) % SAMPLE_COUNT][Frame];
+
+	sf::Vector2i graphPosition = position + sf::Vector2i(0, LINE_HEIGHT * int(StageCount + 1) + 4);
+	target.draw(Graph
+		{
+			.rect = {graphPosition, {int(SAMPLE_COUNT), GRAPH_HEIGHT}},
+			.values = {frameTimes_.data(), count_},
+			.maxValue = GRAPH_MAX_MS,
+			.markValue = FRAME_BUDGET_MS
+		});
+
+	if (!notes.empty())
+		print(graphPosition + sf::Vector2i(0, GRAPH_HEIGHT + 4), Text::TopLeft, notes);
+}
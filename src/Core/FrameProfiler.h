@@ -0,0 +1,112 @@
+#pragma once
+#include "Utils/AllocationTracker.h"
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Per-stage timings of the last frames, drawn as an overlay.
+ *
+ * Samples go in a fixed ring buffer, nothing is allocated. While disabled, a
+ * Scope costs a branch: no clock is read. Statistics are only computed when
+ * the overlay is drawn.
+ *
+ * Built with MPP_TRACK_ALLOCATIONS, scopes also tag heap allocations with
+ * their stage, and the allocations of the last frame are counted per stage,
+ * enabled or not.
+ */
+class FrameProfiler
+{
+public:
+
+	enum Stage : std::uint8_t
+	{
+		PollEvents,
+		GameUpdate,
+		BoardEncode, // on the simulation thread, for the snapshot the frame uploaded
+		BoardUpload, // part of GameUpdate
+		GameRender,
+		UIRender,
+		Display,
+		ProcessCommands,
+		Frame,
+		StageCount
+	};
+
+	static constexpr std::size_t SAMPLE_COUNT = 256;
+
+	static std::string_view getStageName(Stage stage);
+
+	FrameProfiler();
+
+	bool isEnabled() const { return enabled_; }
+	// Starts over with no samples.
+	void setEnabled(bool enabled);
+
+	// Times its own lifetime into 'stage'.
+	class Scope
+	{
+	public:
+
+		Scope(FrameProfiler& profiler, Stage stage)
+			: profiler_(profiler.enabled_ ? &profiler : nullptr)
+			, stage_(stage)
+			, start_(profiler_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{})
+			, allocations_(stage)
+		{}
+
+		~Scope()
+		{
+			if (profiler_)
+				profiler_->add(stage_, std::chrono::steady_clock::now() - start_);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+
+		FrameProfiler* profiler_;
+		Stage stage_;
+		std::chrono::steady_clock::time_point start_;
+		AllocationTracker::Scope allocations_;
+	};
+
+	void beginFrame();
+	void add(Stage stage, std::chrono::nanoseconds time);
+	void endFrame(); // the whole frame time goes in Frame
+
+	// Of the last frame, the whole frame in Frame. Always zero without MPP_TRACK_ALLOCATIONS.
+	using Allocations = std::array<std::uint64_t, StageCount>;
+	const Allocations& getFrameAllocations() const { return allocations_; }
+
+	// 'notes' are printed under the graph.
+	void render(class UITarget& target, sf::Vector2i position, std::string_view notes = {}) const;
+
+private:
+
+	struct Summary
+	{
+		float min, avg, p99; // ms
+	};
+
+	Summary summarize(Stage stage) const;
+
+private:
+
+	bool enabled_;
+	bool inFrame_; // enabled since the frame began
+	std::chrono::steady_clock::time_point frameStart_;
+	std::array<float, StageCount> current_; // ms
+
+	std::array<std::array<float, StageCount>, SAMPLE_COUNT> samples_; // ring, ms
+	std::size_t next_, count_;
+
+	std::array<std::uint64_t, AllocationTracker::TAG_COUNT> allocationsAtStart_;
+	Allocations allocations_;
+
+	// Rendering scratch
+	mutable std::array<float, SAMPLE_COUNT> sorted_, frameTimes_;
+};
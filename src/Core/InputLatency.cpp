@@ -0,0 +1,133 @@
+#include "InputLatency.h"
+#include "UI/Graph.h"
+#include "UI/Text.h"
+#include "UI/UITarget.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+
+namespace
+{
+
+constexpr std::string_view LEG_NAMES[InputLatency::LegCount] =
+{
+	"to open",
+	"to upload",
+	"to display",
+};
+
+constexpr int LINE_HEIGHT = 24;
+constexpr int NAME_WIDTH = 110;
+constexpr int COLUMN_WIDTH = 70;
+constexpr int GRAPH_HEIGHT = 48;
+constexpr int GRAPH_SPACING = 8;
+
+float toMilliseconds(std::chrono::nanoseconds time)
+{
+	return float(time.count()) / 1e6f;
+}
+
+} // namespace
+
+std::string_view InputLatency::getLegName(Leg leg)
+{
+	return LEG_NAMES[leg];
+}
+
+InputLatency::InputLatency()
+	: buckets_{}
+	, max_{}
+	, count_(0)
+	, bars_{}
+{}
+
+void InputLatency::add(Clock::time_point input, Clock::time_point applied, Clock::time_point uploaded, Clock::time_point displayed)
+{
+	const Clock::time_point ends[LegCount] = {applied, uploaded, displayed};
+	for (std::size_t leg = 0; leg < LegCount; ++leg)
+	{
+		auto time = std::max(std::chrono::nanoseconds(ends[leg] - input), std::chrono::nanoseconds::zero());
+		auto steps = std::uint64_t(time / FIRST_BUCKET);
+		std::size_t bucket = std::min(std::size_t(std::bit_width(steps)), BUCKET_COUNT - 1);
+		++buckets_[leg][bucket];
+		max_[leg] = std::max(max_[leg], time);
+	}
+	++count_;
+}
+
+void InputLatency::reset()
+{
+	buckets_ = {};
+	max_ = {};
+	count_ = 0;
+}
+
+std::chrono::nanoseconds InputLatency::getQuantile(Leg leg, float q) const
+{
+	if (count_ == 0)
+		return {};
+
+	auto rank = std::max<std::uint64_t>(1, std::uint64_t(std::ceil(double(q) * double(count_))));
+	std::uint64_t seen = 0;
+	for (std::size_t bucket = 0; bucket < BUCKET_COUNT - 1; ++bucket)
+	{
+		seen += buckets_[leg][bucket];
+		if (seen >= rank)
+			return std::min(FIRST_BUCKET * (std::int64_t(1) << bucket), max_[leg]);
+	}
+	return max_[leg];
+}
+
+void InputLatency::render(UITarget& target, sf::Vector2i position) const
+{
+	auto print = [&](sf::Vector2i at, Text::Origin origin, std::string_view string)
+	{
+		target.draw(Text{.position = at, .origin = origin, .string = string});
+	};
+	auto printNumber = [&](sf::Vector2i at, std::chrono::nanoseconds time)
+	{
+		std::array<char, 16> chars;
+		auto result = std::format_to_n(chars.data(), chars.size(), "{:.2f}", toMilliseconds(time));
+		print(at, Text::TopRight, {chars.data(), std::size_t(result.out - chars.data())});
+	};
+	auto column = [&](int i) { return position + sf::Vector2i(NAME_WIDTH + COLUMN_WIDTH * i, 0); };
+
+	std::array<char, 32> title;
+	auto result = std::format_to_n(title.data(), title.size(), "{} clicks", count_);
+	print(position, Text::TopLeft, {title.data(), std::size_t(result.out - title.data())});
+	print(column(1), Text::TopRight, "p50");
+	print(column(2), Text::TopRight, "p99");
+	print(column(3), Text::TopRight, "max");
+
+	for (std::size_t leg = 0; leg < LegCount; ++leg)
+	{
+		sf::Vector2i line = {0, LINE_HEIGHT * int(leg + 1)};
+		print(position + line, Text::TopLeft, LEG_NAMES[leg]);
+		printNumber(column(1) + line, getQuantile(Leg(leg), 0.5f));
+		printNumber(column(2) + line, getQuantile(Leg(leg), 0.99f));
+		printNumber(column(3) + line, max_[leg]);
+	}
+
+	// One graph per leg, side by side, each scaled to its fullest bucket
+	sf::Vector2i graphPosition = position + sf::Vector2i(0, LINE_HEIGHT * int(LegCount + 1) + 4);
+	constexpr int graphWidth = int(BUCKET_COUNT) * BAR_WIDTH;
+	for (std::size_t leg = 0; leg < LegCount; ++leg)
+	{
+		std::uint64_t fullest = *std::max_element(buckets_[leg].begin(), buckets_[leg].end());
+		for (std::size_t bar = 0; bar < bars_.size(); ++bar)
+			bars_[bar] = float(buckets_[leg][bar / BAR_WIDTH]);
+
+		sf::Vector2i at = graphPosition + sf::Vector2i((graphWidth + GRAPH_SPACING) * int(leg), 0);
+		target.draw(Graph
+			{
+				.rect = {at, {graphWidth, GRAPH_HEIGHT}},
+				.values = bars_,
+				.maxValue = float(std::max<std::uint64_t>(fullest, 1))
+			});
+	}
+
+	std::array<char, 48> legend;
+	result = std::format_to_n(legend.data(), legend.size(), "first bucket {:g} ms, then doubling", toMilliseconds(FIRST_BUCKET));
+	print(graphPosition + sf::Vector2i(0, GRAPH_HEIGHT + 4), Text::TopLeft, {legend.data(), std::size_t(result.out - legend.data())});
+}
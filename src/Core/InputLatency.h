@@ -0,0 +1,57 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Time from a click to its outcome on screen, leg by leg: from the event
+ * taken from the window to the action played by the simulation, to the
+ * snapshot showing it uploaded, to the frame drawing it displayed.
+ *
+ * Each leg counts the clicks into buckets doubling in width, memory is fixed
+ * however long the session. Drawn next to the frame profiler.
+ */
+class InputLatency
+{
+public:
+
+	using Clock = std::chrono::steady_clock;
+
+	enum Leg : std::uint8_t
+	{
+		Applied,   // Board::open or flag done
+		Uploaded,  // state texture updated
+		Displayed, // display returned
+		LegCount
+	};
+
+	static std::string_view getLegName(Leg leg);
+
+	InputLatency();
+
+	// The clocks the click went by, all read on the way.
+	void add(Clock::time_point input, Clock::time_point applied, Clock::time_point uploaded, Clock::time_point displayed);
+	void reset();
+
+	std::uint64_t getCount() const { return count_; }
+	// Upper bound of the bucket holding the quantile 'q', at most the longest click.
+	std::chrono::nanoseconds getQuantile(Leg leg, float q) const;
+
+	void render(class UITarget& target, sf::Vector2i position) const;
+
+private:
+
+	// Bucket i ends at FIRST_BUCKET * 2^i, the last one is open
+	static constexpr std::size_t BUCKET_COUNT = 16;
+	static constexpr std::chrono::nanoseconds FIRST_BUCKET{62'500};
+	static constexpr int BAR_WIDTH = 8;
+
+	std::array<std::array<std::uint64_t, BUCKET_COUNT>, LegCount> buckets_;
+	std::array<std::chrono::nanoseconds, LegCount> max_;
+	std::uint64_t count_;
+
+	// Rendering scratch, each bucket a few pixels wide
+	mutable std::array<float, BUCKET_COUNT * BAR_WIDTH> bars_;
+};
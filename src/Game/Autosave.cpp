@@ -0,0 +1,280 @@
+#include "Autosave.h"
+#include "Utils/MappedFile.h"
+#include "Utils/MyRandom.h"
+#include "Utils/Varint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+constexpr std::uint32_t JOURNAL_MAGIC = 0x4C4A504D; // "MPJL"
+constexpr std::uint32_t JOURNAL_VERSION = 2; // 2: game id
+
+struct JournalHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t gameId;
+	std::uint64_t firstSequence;
+};
+
+constexpr std::uint64_t SNAPSHOT_RECORDS = 16384;
+constexpr std::chrono::seconds SNAPSHOT_PERIOD{30};
+
+} // namespace
+
+Autosave::Autosave(std::filesystem::path snapshotFile, std::filesystem::path journalFile)
+	: snapshotFile_(std::move(snapshotFile))
+	, journalFile_(std::move(journalFile))
+	, snapshotInFlight_(false)
+	, stop_(false)
+	, gameId_(0)
+	, sequence_(0)
+	, snapshotSequence_(0)
+	, stats_{}
+	, journal_(nullptr)
+	, writer_([this] { run(); })
+{}
+
+Autosave::~Autosave()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_one();
+	writer_.join();
+
+	if (journal_)
+		std::fclose(journal_);
+}
+
+void Autosave::begin(Board::Snapshot board, SaveFile::Meta meta)
+{
+	gameId_ = randomSeed();
+	meta.gameId = gameId_;
+	sequence_ = 0;
+	meta.sequence = 0;
+	snapshotSequence_ = 0;
+	snapshotTime_ = std::chrono::steady_clock::now();
+	++stats_.snapshots;
+
+	{
+		// Whatever was pending belongs to the previous game, the new journal drops it
+		std::lock_guard lock(mutex_);
+		pending_.clear();
+		pendingSnapshot_.emplace(PendingSnapshot{std::move(board), std::move(meta), 0});
+		snapshotInFlight_ = true;
+	}
+	wake_.notify_one();
+}
+
+void Autosave::open(std::size_t index)
+{
+	record(Open, index);
+}
+
+void Autosave::flag(std::size_t index)
+{
+	record(Flag, index);
+}
+
+void Autosave::moveMine(std::size_t from, std::size_t to)
+{
+	record(MoveMine, from, to);
+}
+
+void Autosave::pickRunningBomb(std::size_t index)
+{
+	record(RunningBomb, index);
+}
+
+bool Autosave::isSnapshotDue() const
+{
+	if (snapshotInFlight_.load(std::memory_order_relaxed))
+		return false;
+
+	return sequence_ - snapshotSequence_ >= SNAPSHOT_RECORDS
+	       || (sequence_ != snapshotSequence_ && std::chrono::steady_clock::now() - snapshotTime_ >= SNAPSHOT_PERIOD);
+}
+
+void Autosave::snapshot(Board::Snapshot board, SaveFile::Meta meta)
+{
+	meta.gameId = gameId_;
+	meta.sequence = sequence_;
+	snapshotSequence_ = sequence_;
+	snapshotTime_ = std::chrono::steady_clock::now();
+	++stats_.snapshots;
+
+	{
+		std::lock_guard lock(mutex_);
+		pendingSnapshot_.emplace(PendingSnapshot{std::move(board), std::move(meta), pending_.size()});
+		snapshotInFlight_ = true;
+	}
+	wake_.notify_one();
+}
+
+void Autosave::record(Record type, std::size_t index, std::optional<std::size_t> to)
+{
+	auto start = std::chrono::steady_clock::now();
+	{
+		std::lock_guard lock(mutex_);
+		Varint::write(pending_, (std::uint64_t(index) << 2) | type);
+		if (to)
+			Varint::write(pending_, *to);
+	}
+	wake_.notify_one();
+	++sequence_;
+
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	++stats_.records;
+	stats_.recordTime += elapsed;
+	stats_.maxRecordTime = std::max<std::chrono::nanoseconds>(stats_.maxRecordTime, elapsed);
+}
+
+void Autosave::run()
+{
+	std::unique_lock lock(mutex_);
+	while (true)
+	{
+		wake_.wait(lock, [this] { return stop_ || !pending_.empty() || pendingSnapshot_; });
+		if (pending_.empty() && !pendingSnapshot_)
+			break; // stopping, and nothing left to write
+
+		writing_.clear();
+		writing_.swap(pending_);
+		auto snapshot = std::move(pendingSnapshot_);
+		pendingSnapshot_.reset();
+		lock.unlock();
+
+		std::span<const std::uint8_t> bytes = writing_;
+		std::size_t split = snapshot ? snapshot->offset : bytes.size();
+		writeJournal(bytes.first(split));
+
+		if (snapshot)
+		{
+			// The previous journal stays valid until the new snapshot is in place.
+			// If it cannot be written, records are dropped until the next one.
+			if (SaveFile::save(snapshotFile_, snapshot->board, snapshot->meta))
+				startJournal(snapshot->meta.gameId, snapshot->meta.sequence);
+			else if (journal_)
+			{
+				std::fclose(journal_);
+				journal_ = nullptr;
+			}
+			snapshot.reset();
+		}
+
+		writeJournal(bytes.subspan(split));
+		if (journal_)
+			std::fflush(journal_);
+
+		lock.lock();
+		if (!pendingSnapshot_)
+			snapshotInFlight_ = false;
+	}
+}
+
+void Autosave::startJournal(std::uint64_t gameId, std::uint64_t firstSequence)
+{
+	if (journal_)
+		std::fclose(journal_);
+
+	journal_ = std::fopen(journalFile_.string().c_str(), "wb");
+	if (!journal_)
+		return;
+
+	JournalHeader header{.magic = JOURNAL_MAGIC, .version = JOURNAL_VERSION, .gameId = gameId, .firstSequence = firstSequence};
+	std::fwrite(&header, sizeof(header), 1, journal_);
+}
+
+void Autosave::writeJournal(std::span<const std::uint8_t> bytes)
+{
+	// Without a journal, the records are only lost until the next snapshot
+	if (journal_ && !bytes.empty())
+		std::fwrite(bytes.data(), 1, bytes.size(), journal_);
+}
+
+bool Autosave::recover(Board& board, SaveFile::Meta& meta, bool& mineOpened) const
+{
+	Board recovered;
+	SaveFile::Meta recoveredMeta;
+	if (!SaveFile::load(snapshotFile_, recovered, recoveredMeta))
+		return false;
+
+	mineOpened = false;
+	MappedFile journal(journalFile_);
+	auto bytes = journal.bytes();
+
+	JournalHeader header{};
+	if (bytes.size() >= sizeof(header))
+		std::memcpy(&header, bytes.data(), sizeof(header));
+
+	// A journal of an other game, left by a crash before it was started over,
+	// or starting past the snapshot, missing records, cannot be replayed
+	bool replay = header.magic == JOURNAL_MAGIC
+	              && header.version == JOURNAL_VERSION
+	              && header.gameId == recoveredMeta.gameId
+	              && header.firstSequence <= recoveredMeta.sequence;
+
+	std::uint64_t sequence = header.firstSequence;
+	std::size_t pos = sizeof(header);
+	std::uint64_t value, to = 0;
+	while (replay && Varint::read(bytes, pos, value))
+	{
+		auto type = Record(value & 3);
+		std::size_t index = std::size_t(value >> 2);
+		if ((type == MoveMine && !Varint::read(bytes, pos, to)) || !recovered.isIndexValid(index))
+			break;
+
+		if (sequence++ < recoveredMeta.sequence)
+			continue; // already in the snapshot
+
+		switch (type)
+		{
+		case Open:
+			mineOpened |= recovered.open(index);
+			break;
+
+		case Flag:
+			recovered.flag(index);
+			break;
+
+		case MoveMine:
+		{
+			if (!recovered.isIndexValid(std::size_t(to))
+			    || !recovered.getCellAt(index).mined
+			    || recovered.getCellAt(std::size_t(to)).mined)
+			{
+				replay = false;
+				continue;
+			}
+
+			recovered.relocateMine(index, std::size_t(to));
+			auto& bombs = recoveredMeta.runningBombIndexes;
+			std::replace(bombs.begin(), bombs.end(), index, std::size_t(to));
+		}
+		break;
+
+		case RunningBomb:
+		{
+			auto& bombs = recoveredMeta.runningBombIndexes;
+			if (!recovered.getCellAt(index).mined || std::find(bombs.begin(), bombs.end(), index) != bombs.end())
+			{
+				replay = false;
+				continue;
+			}
+			bombs.push_back(index);
+		}
+		break;
+		}
+
+		recoveredMeta.sequence = sequence;
+	}
+
+	board = std::move(recovered);
+	meta = std::move(recoveredMeta);
+	return true;
+}
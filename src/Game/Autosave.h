@@ -0,0 +1,121 @@
+#pragma once
+#include "Board.h"
+#include "SaveFile.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/*
+ * Append-only autosave of the running game.
+ *
+ * Every action on the board is appended to a journal, a couple of bytes each,
+ * along with the running bombs picked at the first click, and the whole board
+ * is snapshotted from time to time in the save format.
+ * Files are only touched by a background thread: recording an action encodes
+ * it into a memory buffer, nothing more. Recovery loads the last snapshot and
+ * replays the journal records it does not hold yet.
+ *
+ * The journal starts with the sequence number of its first record, and each
+ * snapshot stores how many records it holds. A crash between a snapshot and
+ * the journal it starts is then harmless: records already in the snapshot are
+ * skipped. Both also name the game they belong to, drawn at random by begin:
+ * the journal of the previous game is never replayed on a new one.
+ */
+class Autosave
+{
+public:
+
+	inline static const std::filesystem::path DEFAULT_SNAPSHOT = "autosave.mpp";
+	inline static const std::filesystem::path DEFAULT_JOURNAL = "autosave.log";
+
+	struct Stats
+	{
+		std::uint64_t records;
+		std::uint64_t snapshots;
+		std::chrono::nanoseconds recordTime; // total spent by the callers
+		std::chrono::nanoseconds maxRecordTime;
+	};
+
+	Autosave(std::filesystem::path snapshotFile = DEFAULT_SNAPSHOT,
+	         std::filesystem::path journalFile = DEFAULT_JOURNAL);
+	~Autosave(); // writes everything still pending
+
+	Autosave(const Autosave&) = delete;
+	Autosave& operator=(const Autosave&) = delete;
+
+	// Starts over from a snapshot of the board, for a new or a loaded game.
+	void begin(Board::Snapshot board, SaveFile::Meta meta);
+
+	void open(std::size_t index);
+	void flag(std::size_t index);
+	void moveMine(std::size_t from, std::size_t to);
+	// One per running bomb, in the order they were picked.
+	void pickRunningBomb(std::size_t index);
+
+	// After enough records or time, unless a snapshot is still being written.
+	bool isSnapshotDue() const;
+	// The file is written in the background, from the snapshot: the game goes
+	// on meanwhile, without copying the whole board each time.
+	void snapshot(Board::Snapshot board, SaveFile::Meta meta);
+
+	std::uint64_t getSequence() const { return sequence_; }
+	std::uint64_t getGameId() const { return gameId_; }
+	const Stats& getStats() const { return stats_; }
+
+	// Loads the last snapshot and replays the journal on top of it. The journal
+	// ends at the first torn or inconsistent record. 'mineOpened' tells whether a
+	// replayed open hit a mine.
+	bool recover(Board& board, SaveFile::Meta& meta, bool& mineOpened) const;
+
+private:
+
+	enum Record : std::uint8_t
+	{
+		Open,
+		Flag,
+		MoveMine,
+		RunningBomb
+	};
+
+	struct PendingSnapshot
+	{
+		Board::Snapshot board;
+		SaveFile::Meta meta;
+		std::size_t offset; // in the pending bytes, records before it go to the previous journal
+	};
+
+	void record(Record type, std::size_t index, std::optional<std::size_t> to = std::nullopt);
+	void run();
+	void startJournal(std::uint64_t gameId, std::uint64_t firstSequence);
+	void writeJournal(std::span<const std::uint8_t> bytes);
+
+private:
+
+	std::filesystem::path snapshotFile_, journalFile_;
+
+	// Shared with the writer
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::vector<std::uint8_t> pending_;
+	std::optional<PendingSnapshot> pendingSnapshot_;
+	std::atomic<bool> snapshotInFlight_;
+	bool stop_;
+
+	// Caller side
+	std::uint64_t gameId_;
+	std::uint64_t sequence_, snapshotSequence_;
+	std::chrono::steady_clock::time_point snapshotTime_;
+	Stats stats_;
+
+	// Writer side
+	std::vector<std::uint8_t> writing_;
+	std::FILE* journal_;
+
+	std::jthread writer_; // last, so it starts once everything else is built
+};
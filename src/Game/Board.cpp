@@ -1,7 +1,11 @@
 #include "Board.h"
+#include "Utils/JobSystem.h"
 #include "Utils/MyRandom.h"
 #include "Utils/Overloaded.h"
+#include "Utils/Trace.h"
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <limits>
 #include <utility>
@@ -10,6 +14,11 @@
 namespace
 {
 
+// Below, threads cost more than they save
+constexpr std::size_t PARALLEL_PLACEMENT_MIN_CELLS = std::size_t(1) << 22;
+// Small enough for every core to get a few, large enough for the split to be cheap
+constexpr std::size_t STRIPE_CELLS = std::size_t(1) << 18;
+
 // Adds a signed offset to an unsigned coordinate. Returns false on under/overflow.
 constexpr bool tryAddDelta(std::size_t value, std::ptrdiff_t delta, std::size_t& result)
 {
@@ -46,6 +55,68 @@ constexpr std::array<Vec2sDelta, 9> dcoordinates
 	}
 };
 
+// Packs one state bit per cell, 64 cells per word.
+template <class Bit>
+void packLayer(std::span<const Cell> cells, std::span<std::uint64_t> words, Bit&& bit)
+{
+	for (std::size_t w = 0; w < words.size(); ++w)
+	{
+		std::size_t first = w * 64;
+		std::size_t last = std::min(first + 64, cells.size());
+
+		std::uint64_t word = 0;
+		for (std::size_t i = first; i < last; ++i)
+			word |= std::uint64_t(bit(cells[i])) << (i - first);
+		words[w] = word;
+	}
+}
+
+void packLayer(std::span<const Cell> cells, std::span<std::uint64_t> words, Board::Layer layer)
+{
+	switch (layer)
+	{
+	case Board::Layer::Mined: packLayer(cells, words, [](const Cell& c) { return c.mined; });
+		break;
+	case Board::Layer::Opened: packLayer(cells, words, [](const Cell& c) { return c.opened; });
+		break;
+	case Board::Layer::Flagged: packLayer(cells, words, [](const Cell& c) { return c.flagged; });
+		break;
+	}
+}
+
+template <class F>
+void forEachSetBit(std::span<const std::uint64_t> words, F&& f)
+{
+	for (std::size_t w = 0; w < words.size(); ++w)
+	{
+		for (std::uint64_t bits = words[w]; bits; bits &= bits - 1)
+			f(w * 64 + std::size_t(std::countr_zero(bits)));
+	}
+}
+
+// Calls 'f' with the index of the cell and of each of its neighbours, a row at
+// a time: the cheap way around a cell, without coordinates for each.
+template <class F>
+void forEachAround(const Vec2s& size, std::size_t index, F&& f)
+{
+	std::size_t x = index % size.x, y = index / size.x;
+	std::size_t firstX = x ? x - 1 : 0, lastX = std::min(x + 1, size.x - 1);
+	std::size_t firstY = y ? y - 1 : 0, lastY = std::min(y + 1, size.y - 1);
+	for (std::size_t row = firstY; row <= lastY; ++row)
+	{
+		for (std::size_t i = row * size.x + firstX, end = row * size.x + lastX; i <= end; ++i)
+			f(i);
+	}
+}
+
+std::size_t popCount(std::span<const std::uint64_t> words)
+{
+	std::size_t count = 0;
+	for (std::uint64_t word : words)
+		count += std::size_t(std::popcount(word));
+	return count;
+}
+
 } // namespace
 
 constexpr std::optional<Vec2s> Vec2s::operator+(const Vec2sDelta& rhs) const
@@ -93,6 +164,12 @@ Board::Board()
 	, flagCount_{}
 	, openCount_{}
 	, cells_{}
+	, flagsAround_{}
+	, counters_{}
+	, changes_{}
+	, version_(0)
+	, frontierTracked_(false)
+	, frontierSize_(0)
 {}
 
 bool Board::isSizeValid(const Vec2s& size)
@@ -101,10 +178,19 @@ bool Board::isSizeValid(const Vec2s& size)
 		// check overflow
 		return size.x < std::numeric_limits<std::size_t>::max() / size.y
 		       // and respect max_size
-		       && size.x * size.y < std::vector<Cell>().max_size();
+		       && size.x * size.y < Cells().max_size();
 	return false;
 }
 
+std::uint64_t Board::getMemoryFootprint(const Vec2s& size)
+{
+	// Runs pushed by a row scan are a cell apart at least, so the stack never
+	// holds more than half the cells. The corpus lattice, built to split rows
+	// into runs, peaks at an eighth.
+	std::uint64_t cellCount = std::uint64_t(size.x) * size.y;
+	return cellCount * sizeof(Cell) + (cellCount + 1) / 2 + cellCount / 2 * sizeof(std::size_t);
+}
+
 void Board::resize(const Vec2s& size)
 {
 	assert(isSizeValid(size));
@@ -145,51 +231,165 @@ void Board::setMineCount(std::size_t mineCount)
 	mineCount_ = mineCount;
 }
 
-void Board::placeMines()
+void Board::placeMines(JobSystem* jobs)
+{
+	placeMines(gen, jobs);
+}
+
+void Board::placeMines(std::mt19937_64& random, JobSystem* jobs)
 {
 	assert(isSizeValid(size_));
+	if (isPlacementParallel(size_))
+	{
+		placeMinesParallel(random(), jobs);
+		return;
+	}
+	MPP_TRACE_SCOPE("Board::placeMines", "mines", std::int64_t(mineCount_));
+	touch({0, cells_.size()});
 
 	// Fisher-Yates shuffle variant
 	for (std::size_t i = cells_.size() - mineCount_; i < cells_.size(); ++i)
 	{
-		std::uniform_int_distribution<std::size_t> dist(0, i);
-		std::size_t r = dist(gen);
+		std::size_t r = std::size_t(randomBelow(random, i + 1));
 		std::size_t index = cells_[r].mined ? i : r;
 		mineCell(index);
 	}
 }
 
+bool Board::isPlacementParallel(const Vec2s& size)
+{
+	return size.x * size.y >= PARALLEL_PLACEMENT_MIN_CELLS;
+}
+
+void Board::placeMinesParallel(std::uint64_t seed, JobSystem* jobs)
+{
+	assert(isSizeValid(size_));
+	MPP_TRACE_SCOPE("Board::placeMinesParallel", "mines", std::int64_t(mineCount_));
+	touch({0, cells_.size()});
+
+	// Stripes are at least two rows high: mining a cell touches the rows around
+	// it, and two stripes of the same parity must never touch the same row.
+	std::size_t stripeRows = std::max<std::size_t>(2, (STRIPE_CELLS + size_.x - 1) / size_.x);
+	std::size_t stripeCount = std::max<std::size_t>(1, size_.y / stripeRows);
+
+	struct Stripe
+	{
+		std::size_t first, cellCount, mineCount;
+	};
+	std::vector<Stripe> stripes(stripeCount);
+
+	// A multivariate hypergeometric draw, one stripe at a time: what is left of
+	// the mines lands in what is left of the board.
+	CounterRandom split{.key = mix(seed)};
+	std::size_t cellsLeft = cells_.size(), minesLeft = mineCount_;
+	for (std::size_t s = 0; s < stripeCount; ++s)
+	{
+		std::size_t first = s * stripeRows * size_.x;
+		std::size_t cellCount = s + 1 < stripeCount ? stripeRows * size_.x : cells_.size() - first; // the last one takes the rest
+		std::size_t mineCount = std::size_t(randomHypergeometric(split, cellsLeft, minesLeft, cellCount));
+		stripes[s] = {first, cellCount, mineCount};
+		cellsLeft -= cellCount;
+		minesLeft -= mineCount;
+	}
+
+	// As the serial placement, within the stripe
+	auto place = [&](std::size_t s)
+	{
+		const Stripe& stripe = stripes[s];
+		CounterRandom random{.key = mix(seed ^ mix(s))};
+		for (std::size_t i = stripe.cellCount - stripe.mineCount; i < stripe.cellCount; ++i)
+		{
+			std::size_t r = std::size_t(randomBelow(random, i + 1));
+			std::size_t index = stripe.first + (cells_[stripe.first + r].mined ? i : r);
+			mineCell(index);
+		}
+	};
+
+	// Even stripes then odd ones: a stripe only shares rows with its neighbours
+	for (std::size_t parity = 0; parity < 2; ++parity)
+	{
+		std::size_t count = (stripeCount + 1 - parity) / 2;
+		auto placeNth = [&](std::size_t n) { place(parity + 2 * n); };
+		if (jobs)
+			jobs->parallelFor(0, count, 1, placeNth);
+		else
+			for (std::size_t n = 0; n < count; ++n)
+				placeNth(n);
+	}
+}
+
 void Board::clear()
 {
 	assert(isSizeValid(size_));
+	MPP_TRACE_SCOPE("Board::clear");
+	std::size_t cellCount = size_.x * size_.y;
+
+	// The counts are all back to zero once no flag is left
+	if (flagCount_ || flagsAround_.size() != (cellCount + 1) / 2)
+		flagsAround_.assign((cellCount + 1) / 2, 0);
 	flagCount_ = openCount_ = 0;
-	cells_.assign(size_.x * size_.y, {});
+
+	dirtyChunks_.resize(((cellCount + CHUNK_CELLS - 1) / CHUNK_CELLS + 63) / 64);
+	changes_ = {};
+	touch({0, cellCount});
+	if (frontierTracked_)
+		rebuildFrontier();
+#ifndef MPP_BOARD_STD_ALLOCATOR
+	// A restart keeps the size: the cells of a large board, in an arena block,
+	// are dropped rather than written. They come back zeroed, an empty cell,
+	// only as they are touched.
+	if (cells_.size() == cellCount && cells_.capacity() * sizeof(Cell) >= PageArena::MIN_BLOCK)
+	{
+		PageArena::zero(cells_.data(), cellCount * sizeof(Cell));
+		return;
+	}
+#endif // MPP_BOARD_STD_ALLOCATOR
+	cells_.assign(cellCount, {});
 }
 
-void Board::makeSafe(std::size_t index)
+std::size_t Board::makeSafe(std::size_t index)
+{
+	return makeSafe(index, gen);
+}
+
+std::size_t Board::makeSafe(std::size_t index, std::mt19937_64& random)
 {
 	assert(isIndexValid(index));
+	MPP_TRACE_SCOPE("Board::makeSafe", "index", std::int64_t(index));
 
 	auto& cell = cells_[index];
 	if (!cell.mined)
-		return;
+		return index;
+
+	++counters_.makeSafeRelocations;
 
 	// mine the n-th not already mined cell
 	std::size_t spotsLeft = cells_.size() - mineCount_;
-	std::uniform_int_distribution<std::size_t> dist(1, spotsLeft);
-	std::size_t n = dist(gen);
+	std::size_t n = std::size_t(randomBelow(random, spotsLeft)) + 1;
+	std::size_t destination = index;
 	for (std::size_t i = 0; i < cells_.size(); ++i)
 	{
 		if (!cells_[i].mined && --n == 0)
+		{
 			mineCell(i);
+			destination = i;
+		}
 	}
 
 	clearCell(index);
+	mineMoved(index, destination);
+	return destination;
 }
 
 std::size_t Board::moveMine(std::size_t index)
+{
+	return moveMine(index, gen);
+}
+
+std::size_t Board::moveMine(std::size_t index, std::mt19937_64& random)
 {
 	assert(isIndexValid(index));
+	MPP_TRACE_SCOPE("Board::moveMine", "index", std::int64_t(index));
 
 	auto& cell = cells_[index];
 	if (!cell.mined)
@@ -210,16 +410,28 @@ std::size_t Board::moveMine(std::size_t index)
 	}
 
 	if (unoccupiedNbCount == 0)
+	{
+		++counters_.moveMineFailures;
 		return index;
+	}
 
+	++counters_.moveMineSuccesses;
 	clearCell(index);
-	std::uniform_int_distribution<std::size_t> dist(0, unoccupiedNbCount - 1);
-	std::size_t idx = unoccupiedNbIndexes[dist(gen)];
+	std::size_t idx = unoccupiedNbIndexes[randomBelow(random, unoccupiedNbCount)];
 	mineCell(idx);
+	mineMoved(index, idx);
 
 	return idx;
 }
 
+void Board::relocateMine(std::size_t from, std::size_t to)
+{
+	assert(isIndexValid(from) && isIndexValid(to));
+	clearCell(from);
+	mineCell(to);
+	mineMoved(from, to);
+}
+
 struct Board::SeedStack
 {
 #ifdef MPP_BOARD_FIXED_SEED_STACK_CAPACITY
@@ -228,10 +440,22 @@ struct Board::SeedStack
 	static constexpr std::size_t CAPACITY = 32;
 #endif // MPP_BOARD_FIXED_SEED_STACK_CAPACITY
 
-	struct Fixed { std::size_t buf[CAPACITY]; std::size_t top = 0; };
-	struct Heap { std::vector<std::size_t> vec; };
+	// Only 'top' is set: value-initializing would zero the whole buffer on
+	// every open. Not a default member initializer, GCC then deems the variant
+	// not default constructible: nested initializers are parsed after the
+	// enclosing class.
+	struct Fixed
+	{
+		Fixed() : top(0) {}
+		std::size_t buf[CAPACITY];
+		std::size_t top;
+	};
+	struct Heap { std::vector<std::size_t, Allocator<std::size_t>> vec; };
 
 	std::variant<Fixed, Heap> store;
+	std::size_t peak = 0; // deepest it went
+
+	bool spilled() const { return std::holds_alternative<Heap>(store); }
 
 	bool empty() const
 	{
@@ -260,6 +484,7 @@ struct Board::SeedStack
 					if (f.top < CAPACITY)
 					{
 						f.buf[f.top++] = index;
+						peak = std::max(peak, f.top);
 						return;
 					}
 					// Overflow: switch to the heap alternative, carrying the buffered seeds.
@@ -267,9 +492,14 @@ struct Board::SeedStack
 					h.vec.reserve(CAPACITY * 2);
 					h.vec.assign(f.buf, f.buf + f.top);
 					h.vec.push_back(index);
+					peak = std::max(peak, h.vec.size());
 					store.emplace<Heap>(std::move(h));
 				},
-				[&](Heap& h) { h.vec.push_back(index); }
+				[&](Heap& h)
+				{
+					h.vec.push_back(index);
+					peak = std::max(peak, h.vec.size());
+				}
 			}, store);
 	}
 };
@@ -277,25 +507,80 @@ struct Board::SeedStack
 bool Board::open(std::size_t index)
 {
 	assert(isIndexValid(index));
+	MPP_TRACE_SCOPE("Board::open", "index", std::int64_t(index));
+
+	std::size_t openCount = openCount_;
+	SeedStack stack;
+	bool mineOpened = frontierTracked_ ? openFrom<true>(index, stack) : openFrom<false>(index, stack);
+	if (frontierTracked_)
+		sweepFrontier();
+
+	countOpen(openCount, stack);
+	return mineOpened;
+}
+
+bool Board::chordAll()
+{
+	MPP_TRACE_SCOPE("Board::chordAll");
+	bool tracked = frontierTracked_;
+	setFrontierTracked(true);
+
+	// In index order, 64 cells a word: a cascade takes flags away, so the
+	// order decides which numbers are still satisfied once reached. The word
+	// is read again after every chord, for the cells it opened ahead.
+	std::size_t openCount = openCount_;
+	SeedStack stack;
+	bool mineOpened = false;
+	for (std::size_t w = 0; w < frontierBits_.size(); ++w)
+	{
+		for (std::uint64_t bits = frontierBits_[w]; bits;)
+		{
+			std::size_t bit = std::size_t(std::countr_zero(bits));
+			std::size_t index = w * 64 + bit;
+			if (getFlagsAround(index) == cells_[index].adjacentMines)
+				mineOpened |= openFrom<true>(index, stack);
+			bits = frontierBits_[w] & ~((std::uint64_t(2) << bit) - 1);
+		}
+	}
+	sweepFrontier();
+	setFrontierTracked(tracked);
+
+	countOpen(openCount, stack);
+	return mineOpened;
+}
+
+void Board::countOpen(std::size_t openCountBefore, const SeedStack& stack)
+{
+	std::uint64_t opened = openCount_ - openCountBefore;
+	++counters_.openCalls;
+	counters_.cellsOpened += opened;
+	counters_.maxCellsPerOpen = std::max(counters_.maxCellsPerOpen, opened);
+	counters_.seedStackPeak = std::max<std::uint64_t>(counters_.seedStackPeak, stack.peak);
+	counters_.seedStackSpills += stack.spilled();
+}
 
+template <bool TrackFrontier>
+bool Board::openFrom(std::size_t index, SeedStack& stack)
+{
 	auto& first = cells_[index];
 	if (first.flagged)
 		return false;
 
 	bool mineOpened = false;
-	SeedStack stack;
-
 	if (!first.opened)
 	{
+		if (first.mined || first.adjacentMines)
+			touch({index, index + 1});
+
 		if (first.mined)
 		{
-			openCell(first);
+			openCell<TrackFrontier>(first);
 			return true;
 		}
 
 		if (first.adjacentMines)
 		{
-			openCell(first);
+			openCell<TrackFrontier>(first);
 			return false;
 		}
 
@@ -304,24 +589,30 @@ bool Board::open(std::size_t index)
 	else
 	{
 		// Chording: only expand if the flag count matches
-		auto coordinates = toCoordinates(index);
-		std::size_t flaggedNeighbourCount = 0;
-		for (auto& coo : getNeighboursOf(coordinates))
-		{
-			flaggedNeighbourCount += cells_[toIndex(coo)].flagged;
-		}
-
-		if (flaggedNeighbourCount != first.adjacentMines)
+		if (getFlagsAround(index) != first.adjacentMines)
 			return false;
 
-		chord(coordinates, stack, mineOpened);
+		touchAround(index);
+		chord<TrackFrontier>(toCoordinates(index), stack, mineOpened);
 	}
 
+	// A seed only opens cells on its row and the rows around it. The seeds are
+	// bounded in locals, a member would be reloaded after every cell written.
+	std::size_t lowest = cells_.size(), highest = 0;
 	while (!stack.empty())
 	{
-		fillFrom(stack.pop(), stack, mineOpened);
+		std::size_t seed = stack.pop();
+		lowest = std::min(lowest, seed);
+		highest = std::max(highest, seed);
+		fillFrom<TrackFrontier>(seed, stack, mineOpened);
 	}
 
+	if (lowest <= highest)
+	{
+		std::size_t width = size_.x;
+		std::size_t firstRow = lowest / width, lastRow = highest / width + 1;
+		touch({(firstRow ? firstRow - 1 : 0) * width, std::min((lastRow + 1) * width, cells_.size())});
+	}
 	return mineOpened;
 }
 
@@ -332,7 +623,161 @@ void Board::flag(std::size_t index)
 	if (!cell.opened)
 	{
 		flagCount_ += std::size_t(cell.flagged ^= true) * 2 - 1;
+		flagChanged(index, cell.flagged);
+		touch({index, index + 1});
+		if (frontierTracked_)
+		{
+			refreshFrontierAround(index);
+			sweepFrontier();
+		}
+	}
+}
+
+void Board::setFrontierTracked(bool tracked)
+{
+	if (tracked == frontierTracked_)
+		return;
+
+	frontierTracked_ = tracked;
+	if (tracked)
+	{
+		rebuildFrontier();
+		return;
+	}
+
+	// Two bits a cell and the list, given back
+	decltype(frontierBits_)().swap(frontierBits_);
+	decltype(listedBits_)().swap(listedBits_);
+	decltype(frontierList_)().swap(frontierList_);
+	frontierSize_ = 0;
+}
+
+void Board::exportLayer(Layer layer, std::span<std::uint64_t> words) const
+{
+	assert(words.size() == getLayerWordCount(size_));
+	packLayer(cells_, words, layer);
+}
+
+bool Board::importLayers(const Vec2s& size,
+                         std::span<const std::uint64_t> mined,
+                         std::span<const std::uint64_t> opened,
+                         std::span<const std::uint64_t> flagged)
+{
+	// Everything is checked up front, so a bad save leaves the board untouched
+	if (!isSizeValid(size))
+		return false;
+
+	std::size_t wordCount = getLayerWordCount(size);
+	if (mined.size() != wordCount || opened.size() != wordCount || flagged.size() != wordCount)
+		return false;
+
+	std::size_t cellCount = size.x * size.y;
+	std::uint64_t tailMask = cellCount % 64 ? ~std::uint64_t(0) << (cellCount % 64) : 0;
+	if ((mined.back() | opened.back() | flagged.back()) & tailMask)
+		return false;
+
+	for (std::size_t w = 0; w < wordCount; ++w)
+	{
+		// An opened cell cannot hold a flag
+		if (opened[w] & flagged[w])
+			return false;
+	}
+
+	std::size_t mineCount = popCount(mined);
+	if (mineCount >= cellCount)
+		return false;
+
+	resize(size);
+	mineCount_ = mineCount;
+	forEachSetBit(mined, [this](std::size_t i) { mineCell(i); });
+	forEachSetBit(opened, [this](std::size_t i) { cells_[i].opened = true; });
+	forEachSetBit(flagged, [this](std::size_t i) { cells_[i].flagged = true; flagChanged(i, true); });
+	openCount_ = popCount(opened);
+	flagCount_ = popCount(flagged);
+	if (frontierTracked_)
+		rebuildFrontier();
+	return true;
+}
+
+void Board::Extent::merge(const Extent& other)
+{
+	if (other.isEmpty())
+		return;
+	if (isEmpty())
+	{
+		*this = other;
+		return;
 	}
+	first = std::min(first, other.first);
+	last = std::max(last, other.last);
+}
+
+void Board::Snapshot::exportLayer(Layer layer, std::span<std::uint64_t> words) const
+{
+	assert(words.size() == getLayerWordCount(size_));
+	static_assert(CHUNK_CELLS % 64 == 0, "A chunk packs into whole words");
+
+	std::size_t cellCount = size_.x * size_.y;
+	for (std::size_t c = 0; c < chunks_.size(); ++c)
+	{
+		std::size_t first = c * CHUNK_CELLS;
+		std::size_t count = std::min(CHUNK_CELLS, cellCount - first);
+		packLayer({chunks_[c]->data(), count}, words.subspan(first / 64, (count + 63) / 64), layer);
+	}
+}
+
+Board::Snapshot Board::takeSnapshot()
+{
+	MPP_TRACE_SCOPE("Board::takeSnapshot");
+	std::size_t chunkCount = (cells_.size() + CHUNK_CELLS - 1) / CHUNK_CELLS;
+	snapshotChunks_.resize(chunkCount);
+
+	bool changed = false;
+	for (std::size_t c = 0; c < chunkCount; ++c)
+	{
+		std::uint64_t& dirtyWord = dirtyChunks_[c / 64];
+		std::uint64_t bit = std::uint64_t(1) << (c % 64);
+		std::shared_ptr<Chunk>& chunk = snapshotChunks_[c];
+		if (chunk && !(dirtyWord & bit))
+			continue;
+
+		// The use count only drops to one once the last reader let go of it,
+		// with a release: the fence orders its reads before the copy.
+		if (chunk && chunk.use_count() == 1)
+			std::atomic_thread_fence(std::memory_order_acquire);
+		else
+			chunk = std::make_shared_for_overwrite<Chunk>();
+
+		// The tail of the last chunk is left as is, nothing reads past the board
+		std::size_t first = c * CHUNK_CELLS;
+		std::copy_n(cells_.data() + first, std::min(CHUNK_CELLS, cells_.size() - first), chunk->data());
+		dirtyWord &= ~bit;
+		changed = true;
+	}
+	version_ += changed;
+
+	Snapshot snapshot;
+	snapshot.size_ = size_;
+	snapshot.mineCount_ = mineCount_;
+	snapshot.flagCount_ = flagCount_;
+	snapshot.openCount_ = openCount_;
+	snapshot.version_ = version_;
+	snapshot.chunks_.assign(snapshotChunks_.begin(), snapshotChunks_.end());
+	return snapshot;
+}
+
+Board::Counters& Board::Counters::operator+=(const Counters& other)
+{
+	openCalls += other.openCalls;
+	cellsOpened += other.cellsOpened;
+	maxCellsPerOpen = std::max(maxCellsPerOpen, other.maxCellsPerOpen);
+	seedStackPeak = std::max(seedStackPeak, other.seedStackPeak);
+	seedStackSpills += other.seedStackSpills;
+	scanRowPushes += other.scanRowPushes;
+	moveMineSuccesses += other.moveMineSuccesses;
+	moveMineFailures += other.moveMineFailures;
+	makeSafeRelocations += other.makeSafeRelocations;
+	return *this;
 }
 
 void Board::mineCell(std::size_t index)
@@ -357,16 +802,173 @@ void Board::clearCell(std::size_t index)
 	}
 }
 
+void Board::touchAround(std::size_t index)
+{
+	// The rows above and below, from the cell before to the cell after
+	std::size_t reach = size_.x + 1;
+	touch({index > reach ? index - reach : 0, std::min(index + reach + 1, cells_.size())});
+}
+
+void Board::mineMoved(std::size_t from, std::size_t to)
+{
+	touchAround(from);
+	touchAround(to);
+	if (frontierTracked_)
+	{
+		refreshFrontierAround(from);
+		refreshFrontierAround(to);
+		sweepFrontier();
+	}
+}
+
+void Board::flagChanged(std::size_t index, bool flagged)
+{
+	// Counts never go past 8, a nibble never carries into the other
+	forEachAround(size_, index, [&](std::size_t i)
+	{
+		if (i == index)
+			return;
+		auto unit = std::uint8_t(1u << (i % 2 * 4));
+		flagsAround_[i / 2] = std::uint8_t(flagged ? flagsAround_[i / 2] + unit : flagsAround_[i / 2] - unit);
+	});
+}
+
+void Board::touch(const Extent& extent)
+{
+	if (extent.isEmpty())
+		return;
+
+	changes_.merge(extent);
+	std::size_t first = extent.first / CHUNK_CELLS, last = (extent.last - 1) / CHUNK_CELLS;
+	for (std::size_t c = first; c <= last; ++c)
+		dirtyChunks_[c / 64] |= std::uint64_t(1) << (c % 64);
+}
+
+bool Board::isFrontierCell(std::size_t index) const
+{
+	const Cell& cell = cells_[index];
+	if (!cell.opened || cell.mined || !cell.adjacentMines)
+		return false;
+
+	bool closed = false;
+	forEachAround(size_, index, [&](std::size_t i) { closed |= !cells_[i].opened && !cells_[i].flagged; });
+	return closed;
+}
+
+void Board::refreshFrontierAround(std::size_t index)
+{
+	// Whether a cell is on the frontier only depends on the cells around it
+	forEachAround(size_, index, [this](std::size_t i) { setInFrontier(i, isFrontierCell(i)); });
+}
+
+void Board::frontierOpened(std::size_t index)
+{
+	// The cell may join, the members around it may have lost their last closed
+	// neighbour, the others are left as they are. Most cells of a cascade show
+	// no number and have no member around: the bits of the rows around tell,
+	// without working out where the row ends.
+	const Cell& cell = cells_[index];
+	bool mayJoin = cell.adjacentMines && !cell.mined;
+	if (!mayJoin)
+	{
+		bool membersAround = false;
+		std::size_t width = size_.x;
+		for (std::size_t row : {index - width, index, index + width}) // wraps around out of the board
+		{
+			for (std::size_t i = row - 1; i != row + 2; ++i)
+				membersAround |= i < cells_.size() && isInFrontier(i);
+		}
+		if (!membersAround)
+			return;
+	}
+
+	forEachAround(size_, index, [&](std::size_t i)
+	{
+		if (i == index ? mayJoin : isInFrontier(i))
+			setInFrontier(i, isFrontierCell(i));
+	});
+}
+
+void Board::setInFrontier(std::size_t index, bool member)
+{
+	std::uint64_t bit = std::uint64_t(1) << (index % 64);
+	if (member == bool(frontierBits_[index / 64] & bit))
+		return;
+
+	frontierBits_[index / 64] ^= bit;
+	if (!member)
+	{
+		--frontierSize_;
+		return;
+	}
+
+	++frontierSize_;
+	if (!(listedBits_[index / 64] & bit))
+	{
+		listedBits_[index / 64] |= bit;
+		frontierList_.push_back(index);
+	}
+}
+
+void Board::rebuildFrontier()
+{
+	std::size_t wordCount = getLayerWordCount(size_);
+	frontierBits_.assign(wordCount, 0);
+	listedBits_.assign(wordCount, 0);
+	frontierList_.clear();
+	frontierSize_ = 0;
+	if (!openCount_)
+		return;
+
+	for (std::size_t i = 0; i < cells_.size(); ++i)
+	{
+		if (!isFrontierCell(i))
+			continue;
+
+		frontierBits_[i / 64] |= std::uint64_t(1) << (i % 64);
+		listedBits_[i / 64] |= std::uint64_t(1) << (i % 64);
+		frontierList_.push_back(i);
+		++frontierSize_;
+	}
+}
+
+void Board::sweepFrontier()
+{
+	// Former members are swept out once they outnumber the members: a walk
+	// stays O(frontier), and each sweep is paid for by the removals before it.
+	if (frontierList_.size() <= 2 * frontierSize_)
+		return;
+
+	std::erase_if(frontierList_, [this](std::size_t i)
+	{
+		std::uint64_t bit = std::uint64_t(1) << (i % 64);
+		if (frontierBits_[i / 64] & bit)
+			return false;
+		listedBits_[i / 64] &= ~bit;
+		return true;
+	});
+}
+
+template <bool TrackFrontier>
 bool Board::openCell(Cell& cell)
 {
 	assert(!cell.opened);
 	cell.opened = true;
-	flagCount_ -= cell.flagged;
-	cell.flagged = false;
 	++openCount_;
+	// A cascade takes flags away
+	if (cell.flagged)
+	{
+		cell.flagged = false;
+		--flagCount_;
+		flagChanged(std::size_t(&cell - cells_.data()), false);
+	}
+	// The cell may join the frontier, the numbers around it may leave it
+	if constexpr (TrackFrontier)
+		frontierOpened(std::size_t(&cell - cells_.data()));
 	return cell.mined;
 }
 
+template <bool TrackFrontier>
 void Board::chord(const Vec2s& cursor, SeedStack& stack, bool& mineOpened)
 {
 	for (auto& coo : getNeighboursOf(cursor))
@@ -378,12 +980,13 @@ void Board::chord(const Vec2s& cursor, SeedStack& stack, bool& mineOpened)
 			continue;
 
 		if (cell.adjacentMines)
-			mineOpened |= openCell(cell);
+			mineOpened |= openCell<TrackFrontier>(cell);
 		else
 			stack.push(index);
 	}
 }
 
+template <bool TrackFrontier>
 void Board::fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened)
 {
 	auto& seed = cells_[index];
@@ -396,7 +999,7 @@ void Board::fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened)
 	std::size_t rEnd = rBeg + width - 1;
 
 	// Open row (left and right) until numbers
-	mineOpened |= openCell(seed);
+	mineOpened |= openCell<TrackFrontier>(seed);
 	std::size_t l = index, r = index;
 
 	while (l > rBeg)
@@ -405,7 +1008,7 @@ void Board::fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened)
 		if (cell.opened)
 			break;
 
-		mineOpened |= openCell(cell);
+		mineOpened |= openCell<TrackFrontier>(cell);
 		if (cell.adjacentMines)
 			break;
 
@@ -418,7 +1021,7 @@ void Board::fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened)
 		if (cell.opened)
 			break;
 
-		mineOpened |= openCell(cell);
+		mineOpened |= openCell<TrackFrontier>(cell);
 		if (cell.adjacentMines)
 			break;
 
@@ -429,11 +1032,12 @@ void Board::fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened)
 	std::size_t b = (r < rEnd) ? r + 1 : r;
 
 	if (index >= width)
-		scanRow(a - width, b - width, stack, mineOpened);
+		scanRow<TrackFrontier>(a - width, b - width, stack, mineOpened);
 	if (index + width < cells_.size())
-		scanRow(a + width, b + width, stack, mineOpened);
+		scanRow<TrackFrontier>(a + width, b + width, stack, mineOpened);
 }
 
+template <bool TrackFrontier>
 void Board::scanRow(std::size_t l, std::size_t r, SeedStack& stack, bool& mineOpened)
 {
 	for (std::size_t i = l; i <= r; ++i)
@@ -445,11 +1049,12 @@ void Board::scanRow(std::size_t l, std::size_t r, SeedStack& stack, bool& mineOp
 		if (cell.adjacentMines)
 		{
 			// Can be opened now without recursion
-			mineOpened |= openCell(cell);
+			mineOpened |= openCell<TrackFrontier>(cell);
 			continue;
 		}
 
 		stack.push(i);
+		++counters_.scanRowPushes;
 		while (i < r)
 		{
 			auto next = cells_[i + 1];
@@ -1,8 +1,13 @@
 #pragma once
+#include "Utils/PageArena.h"
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <random>
+#include <span>
+#include <utility>
 #include <vector>
 
 struct Cell
@@ -57,9 +62,21 @@ public:
 	Board& operator=(const Board&) = default;
 	Board& operator=(Board&&) noexcept = default;
 
+	// Storage of the cells and of the flood fill stack. Built with
+	// MPP_BOARD_STD_ALLOCATOR, the general purpose allocator, to compare.
+#ifdef MPP_BOARD_STD_ALLOCATOR
+	template <class T> using Allocator = std::allocator<T>;
+#else
+	template <class T> using Allocator = PageAllocator<T>;
+#endif // MPP_BOARD_STD_ALLOCATOR
+	using Cells = std::vector<Cell, Allocator<Cell>>;
+
 public: // setup methods
 
 	static bool isSizeValid(const Vec2s& size);
+	// Heap bytes a board of that size takes: its cells, and the flood fill stack
+	// at its worst.
+	static std::uint64_t getMemoryFootprint(const Vec2s& size);
 	void resize(const Vec2s& size);
 	const Vec2s& getSize() const { return size_; }
 
@@ -72,16 +89,32 @@ public: // setup methods
 	void setMineCount(std::size_t mineCount);
 	std::size_t getMineCount() const { return mineCount_; }
 
-	void placeMines();
+	// Draws from 'random', or from 'gen' without. Large boards are placed in
+	// parallel, from a seed drawn, on 'jobs' if given.
+	void placeMines(class JobSystem* jobs = nullptr);
+	void placeMines(std::mt19937_64& random, JobSystem* jobs = nullptr);
+	static bool isPlacementParallel(const Vec2s& size);
+	// The board is split in stripes of rows, the mine count across them with a
+	// hypergeometric draw per stripe, then every stripe is mined from its own
+	// random stream. The layout only depends on 'seed' and the board size,
+	// whatever the number of threads 'jobs' has, or on the caller alone if null.
+	void placeMinesParallel(std::uint64_t seed, JobSystem* jobs = nullptr);
 	void clear();
 
 	// Make sure the 'index' cell is not mined, moving the mine to an other random
 	// cell. Only the last index passed to this function is guarenteed safe.
-	void makeSafe(std::size_t index);
+	// Returns the new index of the mine, or 'index' if there was none.
+	std::size_t makeSafe(std::size_t index);
+	std::size_t makeSafe(std::size_t index, std::mt19937_64& random);
 
 	// Move the mine at 'index' to a neighbour and returns its new index.
 	// The returned index can be the same as 'index' if the method failed.
 	std::size_t moveMine(std::size_t index);
+	std::size_t moveMine(std::size_t index, std::mt19937_64& random);
+
+	// Move the mine at 'from' to 'to', which must not be mined.
+	// Replays a random move made earlier by makeSafe or moveMine.
+	void relocateMine(std::size_t from, std::size_t to);
 
 public: // playing methods
 
@@ -91,29 +124,186 @@ public: // playing methods
 
 	void flag(std::size_t index);
 	std::size_t getFlagCount() const { return flagCount_; }
+	// Flagged neighbours of the cell, kept up to date: a chord is checked in O(1).
+	std::size_t getFlagsAround(std::size_t index) const { return flagsAround_[index / 2] >> (index % 2 * 4) & 15; }
+
+	// Chords every opened number with as many flags around as it shows, one
+	// pass in index order: the numbers it opens ahead are taken too, those
+	// behind are left to the next call. Walks the frontier bits, built for the
+	// call if not tracked. Returns true if a mine opened.
+	bool chordAll();
 
 	bool isWon() const { return openCount_ == cells_.size() - mineCount_; }
 
 	const Cell& getCellAt(std::size_t index) const { return cells_[index]; }
-	const std::vector<Cell>& getCells() const { return cells_; }
+	const Cells& getCells() const { return cells_; }
 	NeighbourRange getNeighboursOf(const Vec2s& coordinates) const { return {*this, coordinates}; }
 
+public: // change tracking
+
+	// Cells from 'first' to 'last' excluded, empty if 'first' is not below 'last'.
+	struct Extent
+	{
+		std::size_t first, last;
+
+		bool isEmpty() const { return first >= last; }
+		void merge(const Extent& other);
+	};
+
+	// Cells that may look different since the last call, so that views of the
+	// board only refresh those: opened and flagged cells, and the neighbours of
+	// the mines moved, whose number changed. Clearing the board changes it all.
+	Extent takeChanges() { return std::exchange(changes_, {}); }
+
+public: // frontier
+
+	// Opened cells showing a number that still have a closed, unflagged
+	// neighbour: where a solver, a hint or a bot has something to work out.
+	// Off by default. Once tracked, every change updates it around the cells
+	// it changed, and walking it costs O(frontier) instead of a board scan.
+	void setFrontierTracked(bool tracked);
+	bool isFrontierTracked() const { return frontierTracked_; }
+	std::size_t getFrontierSize() const { return frontierSize_; }
+
+	// Calls 'f' with the index of every frontier cell, in no particular order.
+	template <class F>
+	void forEachFrontierCell(F&& f) const
+	{
+		for (std::size_t index : frontierList_)
+		{
+			if (isInFrontier(index))
+				f(index);
+		}
+	}
+
+public: // persistence
+
+	// A layer holds one state bit per cell, packed 64 cells per word:
+	// cell i is bit (i % 64) of word (i / 64). Trailing bits are zero.
+	enum class Layer { Mined, Opened, Flagged };
+	static std::size_t getLayerWordCount(const Vec2s& size) { return (size.x * size.y + 63) / 64; }
+	void exportLayer(Layer layer, std::span<std::uint64_t> words) const;
+
+	// Rebuilds the whole board from its layers. Words are visited a set bit at a
+	// time, so empty stretches of the board cost nothing. Returns false if the
+	// layers are inconsistent, checked before anything is written: the board is
+	// then left untouched.
+	bool importLayers(const Vec2s& size,
+	                  std::span<const std::uint64_t> mined,
+	                  std::span<const std::uint64_t> opened,
+	                  std::span<const std::uint64_t> flagged);
+
+public: // snapshots
+
+	// Snapshots share the cells by chunks of that many, a whole number of layer words.
+	static constexpr std::size_t CHUNK_CELLS = std::size_t(1) << 16;
+	using Chunk = std::array<Cell, CHUNK_CELLS>;
+
+	// The board as it was when taken: immutable, so any thread can read it, for
+	// as long as it likes, while the game goes on. Copies are cheap, chunks are
+	// shared.
+	class Snapshot
+	{
+	public:
+
+		const Vec2s& getSize() const { return size_; }
+		std::size_t getMineCount() const { return mineCount_; }
+		std::size_t getFlagCount() const { return flagCount_; }
+		std::size_t getOpenCount() const { return openCount_; }
+		// Goes up with every snapshot taken after the board changed.
+		std::uint64_t getVersion() const { return version_; }
+
+		const Cell& getCellAt(std::size_t index) const { return (*chunks_[index / CHUNK_CELLS])[index % CHUNK_CELLS]; }
+		void exportLayer(Layer layer, std::span<std::uint64_t> words) const;
+
+	private:
+
+		friend class Board;
+
+		Vec2s size_ = {};
+		std::size_t mineCount_ = 0, flagCount_ = 0, openCount_ = 0;
+		std::uint64_t version_ = 0;
+		std::vector<std::shared_ptr<const Chunk>> chunks_;
+	};
+
+	// Costs a pointer per chunk, plus a copy of the chunks written to since the
+	// previous snapshot. A chunk no older snapshot holds anymore is written over,
+	// the others are left to their readers.
+	Snapshot takeSnapshot();
+
+public: // statistics
+
+	// Operation counts, cheap enough to be always on. They pile up until reset:
+	// the game resets them on restart for per game figures.
+	struct Counters
+	{
+		std::uint64_t openCalls;
+		std::uint64_t cellsOpened;
+		std::uint64_t maxCellsPerOpen;
+		std::uint64_t seedStackPeak;       // deepest flood fill stack
+		std::uint64_t seedStackSpills;     // flood fills that outgrew the fixed stack
+		std::uint64_t scanRowPushes;
+		std::uint64_t moveMineSuccesses;
+		std::uint64_t moveMineFailures;    // no free neighbour, the mine stays
+		std::uint64_t makeSafeRelocations;
+
+		// Maxima are kept, the rest is summed.
+		Counters& operator+=(const Counters& other);
+	};
+
+	const Counters& getCounters() const { return counters_; }
+	void resetCounters() { counters_ = {}; }
+
 private: // setup helpers
 
 	void mineCell(std::size_t index);
 	void clearCell(std::size_t index);
+	void touch(const Extent& extent);
+	void touchAround(std::size_t index);
+	// The numbers around both cells changed
+	void mineMoved(std::size_t from, std::size_t to);
+	// The counts around a cell that gained or lost its flag
+	void flagChanged(std::size_t index, bool flagged);
+
+private: // frontier helpers
+
+	bool isFrontierCell(std::size_t index) const;
+	bool isInFrontier(std::size_t index) const { return frontierBits_[index / 64] >> (index % 64) & 1; }
+	void setInFrontier(std::size_t index, bool member);
+	void refreshFrontierAround(std::size_t index);
+	void frontierOpened(std::size_t index);
+	void rebuildFrontier();
+	void sweepFrontier();
 
 private: // open helpers
 
+	// Instantiated twice: the flood fill only pays for the frontier when tracked.
 	struct SeedStack;
-	bool openCell(Cell& cell);
-	void chord(const Vec2s& cursor, SeedStack& stack, bool& mineOpened);
-	void fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened);
-	void scanRow(std::size_t l, std::size_t r, SeedStack& stack, bool& mineOpened);
+	void countOpen(std::size_t openCountBefore, const SeedStack& stack);
+	template <bool TrackFrontier> bool openFrom(std::size_t index, SeedStack& stack);
+	template <bool TrackFrontier> bool openCell(Cell& cell);
+	template <bool TrackFrontier> void chord(const Vec2s& cursor, SeedStack& stack, bool& mineOpened);
+	template <bool TrackFrontier> void fillFrom(std::size_t index, SeedStack& stack, bool& mineOpened);
+	template <bool TrackFrontier> void scanRow(std::size_t l, std::size_t r, SeedStack& stack, bool& mineOpened);
 
 private:
 
 	Vec2s size_;
 	std::size_t mineCount_, flagCount_, openCount_;
-	std::vector<Cell> cells_;
+	Cells cells_;
+	std::vector<std::uint8_t, Allocator<std::uint8_t>> flagsAround_; // a count per 4 bits
+	Counters counters_;
+	Extent changes_;
+
+	// Latest copy of every chunk, and the chunks written to since
+	std::vector<std::shared_ptr<Chunk>> snapshotChunks_;
+	std::vector<std::uint64_t> dirtyChunks_; // one bit per chunk
+	std::uint64_t version_;
+
+	// One bit per cell each: in the frontier, and in the list. The list holds
+	// the members and the former ones not swept out yet, each cell once.
+	bool frontierTracked_;
+	std::vector<std::uint64_t, Allocator<std::uint64_t>> frontierBits_, listedBits_;
+	std::vector<std::size_t, Allocator<std::size_t>> frontierList_;
+	std::size_t frontierSize_;
 };
@@ -0,0 +1,73 @@
+#include "BoardEncoder.h"
+#include "Board.h"
+#include "Tile.h"
+#include <cassert>
+
+namespace
+{
+
+using Resources::Textures::Tile;
+using BoardEncoder::Reveal;
+
+constexpr std::uint8_t toByte(Tile tile)
+{
+	return static_cast<std::uint8_t>(tile);
+}
+
+Tile tileAt(const Board& board, const BoardEncoder::State& state, std::size_t index)
+{
+	const Cell& cell = board.getCellAt(index);
+
+	if (cell.flagged)
+	{
+		// Wrong flags are only called out on a loss, a win keeps them as is
+		return (state.reveal == Reveal::Lost && !cell.mined)
+		       ? Tile::OpenedNoMine
+		       : Tile::UnopenedFlagged;
+	}
+
+	if (!cell.opened)
+	{
+		return (state.reveal != Reveal::None && cell.mined)
+		       ? Tile::OpenedMine
+		       : (state.pressedCellIndex == index)
+		         ? Tile::UnopenedSelected
+		         : Tile::Unopened;
+	}
+
+	if (cell.mined)
+	{
+		return Tile::OpenedClickedMine;
+	}
+
+	// Opened0 through Opened8 are consecutive
+	assert(cell.adjacentMines < 9);
+	return Tile(toByte(Tile::Opened0) + cell.adjacentMines);
+}
+
+} // namespace
+
+void BoardEncoder::encode(const Board& board, const State& state, std::size_t first, std::span<std::uint8_t> out)
+{
+	std::size_t last = first + out.size();
+	assert(last <= board.getCells().size());
+
+	for (std::size_t index = first; index < last; ++index)
+		out[index - first] = toByte(tileAt(board, state, index));
+
+	// Running bombs are patched in place rather than in a second pass over the
+	// board: there are only a handful of them, so skipping the ones outside the
+	// block is cheaper than sorting the list.
+	for (std::size_t index : state.runningMineIndexes)
+	{
+		if (index < first || index >= last)
+			continue;
+
+		const Cell& cell = board.getCellAt(index);
+		assert(cell.mined);
+
+		// Overrides the flag: a revealed running bomb always shows its own skin
+		if (state.reveal != Reveal::None || cell.opened)
+			out[index - first] = toByte(Tile::OpenedRunningMine);
+	}
+}
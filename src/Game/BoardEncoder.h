@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+class Board;
+
+/*
+ * Turns cells into the Tile the board shader draws, one byte per cell.
+ * Kept out of the renderer and free of SFML, so the headless tools can
+ * measure it.
+ */
+namespace BoardEncoder
+{
+
+// How the board is revealed once the game is over.
+enum class Reveal : std::uint8_t
+{
+	None, // game still running, nothing is revealed
+	Lost, // every mine is shown, wrong flags are marked
+	Won   // unflagged mines are shown, flags are kept
+};
+
+struct State
+{
+	Reveal reveal;
+	std::optional<std::size_t> pressedCellIndex;
+	const std::vector<std::size_t>& runningMineIndexes;
+};
+
+// Encodes the cells from 'first' on, as many as 'out' holds.
+void encode(const Board& board, const State& state, std::size_t first, std::span<std::uint8_t> out);
+
+} // namespace BoardEncoder
@@ -1,7 +1,9 @@
 #include "BoardRenderer.h"
 #include "Board.h"
 #include "Game/Resources.h"
+#include "Utils/Trace.h"
 #include <algorithm>
+#include <array>
 #include <cassert>
 
 namespace
@@ -21,49 +23,21 @@ constexpr std::size_t STATE_TEX_WIDTH_LOG2 = 10;
 constexpr std::size_t STATE_TEX_WIDTH = std::size_t(1) << STATE_TEX_WIDTH_LOG2;
 constexpr std::size_t CELLS_PER_TEX_ROW = STATE_TEX_WIDTH * CELLS_PER_TEXEL;
 
+constexpr std::size_t BYTES_PER_TEXEL = 4;
+
 constexpr std::uint8_t toByte(Tile tile)
 {
 	return static_cast<std::uint8_t>(tile);
 }
 
-Tile tileAt(const Board& board, const BoardRenderer::State& state, std::size_t index)
-{
-	using Reveal = BoardRenderer::Reveal;
-	const Cell& cell = board.getCellAt(index);
-
-	if (cell.flagged)
-	{
-		// Wrong flags are only called out on a loss, a win keeps them as is
-		return (state.reveal == Reveal::Lost && !cell.mined)
-		       ? Tile::OpenedNoMine
-		       : Tile::UnopenedFlagged;
-	}
-
-	if (!cell.opened)
-	{
-		return (state.reveal != Reveal::None && cell.mined)
-		       ? Tile::OpenedMine
-		       : (state.pressedCellIndex == index)
-		         ? Tile::UnopenedSelected
-		         : Tile::Unopened;
-	}
-
-	if (cell.mined)
-	{
-		return Tile::OpenedClickedMine;
-	}
-
-	// Opened0 through Opened8 are consecutive
-	assert(cell.adjacentMines < 9);
-	return Tile(toByte(Tile::Opened0) + cell.adjacentMines);
-}
-
 } // namespace
 
 BoardRenderer::BoardRenderer()
-	: scratch_{}
+	: size_{}
+	, uploadedSequence_(0)
 	, shader_(Resources::Shaders::cell())
-	, dirty_(true)
+	, profiling_(false)
+	, timings_{}
 {
 	shader_.setUniform("atlasTex", sf::Shader::CurrentTexture);
 	shader_.setUniform("atlasCellSize", Resources::Textures::cellSize);
@@ -71,9 +45,26 @@ BoardRenderer::BoardRenderer()
 	shader_.setUniform("stateTexWidthLog2", int(STATE_TEX_WIDTH_LOG2));
 }
 
-void BoardRenderer::resize(const Board& board)
+Vec2s BoardRenderer::getStateTextureSize(const Vec2s& boardSize)
+{
+	std::size_t cellCount = boardSize.x * boardSize.y;
+	return {STATE_TEX_WIDTH, (cellCount + CELLS_PER_TEX_ROW - 1) / CELLS_PER_TEX_ROW};
+}
+
+std::uint64_t BoardRenderer::getStateTextureBytes(const Vec2s& boardSize)
 {
-	Vec2s size = board.getSize();
+	Vec2s texels = getStateTextureSize(boardSize);
+	return std::uint64_t(texels.x) * texels.y * BYTES_PER_TEXEL;
+}
+
+std::size_t BoardRenderer::getTileCount(const Vec2s& boardSize)
+{
+	return getStateTextureSize(boardSize).y * CELLS_PER_TEX_ROW;
+}
+
+void BoardRenderer::resize(const Vec2s& size)
+{
+	size_ = size;
 
 	boardQuad_.setPrimitiveType(sf::PrimitiveType::TriangleStrip);
 	boardQuad_.resize(4);
@@ -83,73 +74,90 @@ void BoardRenderer::resize(const Board& board)
 	boardQuad_[3].position = {float(size.x), float(size.y)};
 
 	// Fails past GL_MAX_TEXTURE_SIZE rows, which is 16384 cells of height on most
-	// drivers: a full 67 million cells at this texture width.
-	std::size_t cellCount = size.x * size.y;
-	std::size_t texRows = (cellCount + CELLS_PER_TEX_ROW - 1) / CELLS_PER_TEX_ROW;
-	[[maybe_unused]] bool resized = stateTexture_.resize({unsigned(STATE_TEX_WIDTH), unsigned(texRows)});
+	// drivers: a full 67 million cells at this texture width. The custom game
+	// menu turns such boards down.
+	Vec2s texels = getStateTextureSize(size);
+	[[maybe_unused]] bool resized = stateTexture_.resize({unsigned(texels.x), unsigned(texels.y)});
 	assert(resized);
 
 	// Rebinds the state texture: resizing it gives the shader a new GL object.
 	shader_.setUniform("stateTex", stateTexture_);
 	shader_.setUniform("boardSize", sf::Vector2f(float(size.x), float(size.y)));
 
-	// The freshly allocated texture holds garbage until the first upload.
-	dirty_ = true;
+	// The freshly allocated texture holds garbage, nothing is pressed on it
+	pressedCellIndex_.reset();
 }
 
-void BoardRenderer::update(const Board& board, const State& state)
+void BoardRenderer::update(const BoardSnapshot& snapshot, std::optional<std::size_t> pressedCellIndex)
 {
-	if (!dirty_) return;
-	dirty_ = false;
-
-	Vec2s size = board.getSize();
-	for (std::size_t first = 0, cellCount = size.x * size.y; first < cellCount; first += scratch_.size())
+	timings_ = {};
+	bool fresh = snapshot.sequence != uploadedSequence_;
+	if (!fresh && pressedCellIndex == pressedCellIndex_)
+		return;
+	if (snapshot.size.x * snapshot.size.y == 0)
+		return;
+	MPP_TRACE_SCOPE("BoardRenderer::update");
+
+	using Clock = std::chrono::steady_clock;
+	auto stamp = [this] { return profiling_ ? Clock::now() : Clock::time_point{}; };
+	auto uploadStart = stamp();
+
+	if (fresh)
 	{
-		std::size_t last = std::min(first + scratch_.size(), cellCount);
+		uploadedSequence_ = snapshot.sequence;
+		timings_.encode = snapshot.encodeTime;
 
-		for (std::size_t index = first; index < last; ++index)
-			scratch_[index - first] = toByte(tileAt(board, state, index));
-
-		// Running bombs are patched in place rather than in a second pass over the
-		// board: there are only a handful of them, so skipping the ones outside the
-		// block is cheaper than sorting the list.
-		for (std::size_t index : state.runningMineIndexes)
+		Board::Extent changed = snapshot.changed;
+		if (snapshot.size != size_)
 		{
-			if (index < first || index >= last)
-				continue;
-
-			const Cell& cell = board.getCellAt(index);
-			assert(cell.mined);
-
-			// Overrides the flag: a revealed running bomb always shows its own skin
-			if (state.reveal != Reveal::None || cell.opened)
-				scratch_[index - first] = toByte(Tile::OpenedRunningMine);
+			resize(snapshot.size);
+			changed = {0, snapshot.size.x * snapshot.size.y};
 		}
 
-		flushScratch(first, last - first);
+		// Whole rows, straight from the snapshot: they are padded for it
+		if (!changed.isEmpty())
+			uploadRows(snapshot, changed.first / CELLS_PER_TEX_ROW, (changed.last + CELLS_PER_TEX_ROW - 1) / CELLS_PER_TEX_ROW);
 	}
+
+	// The pressed cell is restored from the snapshot, which may have changed
+	// under it, then the new one laid on top
+	if (pressedCellIndex_)
+		uploadTexelOf(snapshot, *pressedCellIndex_, false);
+	pressedCellIndex_ = pressedCellIndex;
+	if (pressedCellIndex_)
+		uploadTexelOf(snapshot, *pressedCellIndex_, true);
+
+	timings_.upload = stamp() - uploadStart;
+}
+
+void BoardRenderer::uploadRows(const BoardSnapshot& snapshot, std::size_t firstRow, std::size_t lastRow)
+{
+	assert(lastRow * CELLS_PER_TEX_ROW <= snapshot.tiles.size());
+	MPP_TRACE_SCOPE("BoardRenderer::uploadRows", "rows", std::int64_t(lastRow - firstRow));
+
+	stateTexture_.update(
+		snapshot.tiles.data() + firstRow * CELLS_PER_TEX_ROW,
+		{unsigned(STATE_TEX_WIDTH), unsigned(lastRow - firstRow)},
+		{0, unsigned(firstRow)});
 }
 
-void BoardRenderer::flushScratch(std::size_t first, std::size_t count)
+void BoardRenderer::uploadTexelOf(const BoardSnapshot& snapshot, std::size_t index, bool pressed)
 {
-	// A load goes up as a single run of texels inside one texture row, so a row
-	// must be a whole number of loads for a run to never straddle two rows.
-	static_assert(CELLS_PER_TEX_ROW % std::tuple_size_v<decltype(scratch_)> == 0);
-	assert(first % scratch_.size() == 0 && count <= scratch_.size());
+	assert(index < snapshot.size.x * snapshot.size.y);
 
-	std::size_t firstTexel = first / CELLS_PER_TEXEL;
-	std::size_t texels = (count + CELLS_PER_TEXEL - 1) / CELLS_PER_TEXEL;
+	std::size_t texel = index / CELLS_PER_TEXEL;
+	std::array<std::uint8_t, CELLS_PER_TEXEL> channels;
+	std::copy_n(snapshot.tiles.data() + texel * CELLS_PER_TEXEL, CELLS_PER_TEXEL, channels.begin());
 
-	// A board rarely ends on a texel boundary, and only whole texels can be
-	// uploaded. Those trailing cells do not exist, but leaving the previous load
-	// behind would put stale Tiles in the texture.
-	using diff = decltype(scratch_)::difference_type;
-	std::fill(scratch_.begin() + diff(count), scratch_.begin() + diff(texels * CELLS_PER_TEXEL), toByte(Tile::Unopened));
+	// Only a closed cell, without anything on it, shows being pressed
+	std::uint8_t& tile = channels[index % CELLS_PER_TEXEL];
+	if (pressed && tile == toByte(Tile::Unopened))
+		tile = toByte(Tile::UnopenedSelected);
 
 	stateTexture_.update(
-		scratch_.data(),
-		{unsigned(texels), 1},
-		{unsigned(firstTexel % STATE_TEX_WIDTH), unsigned(firstTexel / STATE_TEX_WIDTH)});
+		channels.data(),
+		{1, 1},
+		{unsigned(texel % STATE_TEX_WIDTH), unsigned(texel / STATE_TEX_WIDTH)});
 }
 
 void BoardRenderer::render(sf::RenderTarget& target) const
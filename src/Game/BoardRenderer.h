@@ -1,12 +1,14 @@
 #pragma once
+#include "Board.h"
+#include "BoardEncoder.h"
+#include "BoardSnapshot.h"
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/VertexArray.hpp>
 #include <SFML/Graphics/Shader.hpp>
 #include <SFML/Graphics/Texture.hpp>
-#include <array>
+#include <chrono>
 #include <cstdint>
-
-class Board;
+#include <optional>
 
 class BoardRenderer
 {
@@ -14,36 +16,46 @@ public:
 
 	BoardRenderer();
 
-	// How the board is revealed once the game is over.
-	enum class Reveal : std::uint8_t
-	{
-		None, // game still running, nothing is revealed
-		Lost, // every mine is shown, wrong flags are marked
-		Won   // unflagged mines are shown, flags are kept
-	};
+	using Reveal = BoardEncoder::Reveal;
+	using State = BoardEncoder::State;
 
-	struct State
-	{
-		Reveal reveal;
-		std::optional<std::size_t> pressedCellIndex;
-		const std::vector<std::size_t>& runningMineIndexes;
-	};
+	// Texels of the state texture for a board of that size, the height being the
+	// one limited by GL_MAX_TEXTURE_SIZE, and the video memory it takes.
+	static Vec2s getStateTextureSize(const Vec2s& boardSize);
+	static std::uint64_t getStateTextureBytes(const Vec2s& boardSize);
+	// Tiles a snapshot holds for a board of that size: whole texture rows.
+	static std::size_t getTileCount(const Vec2s& boardSize);
 
-	void resize(const Board& board);
-	void update(const Board& board, const State& state);
+	// Uploads the rows of the snapshot that changed since the last one, if it
+	// is a new one, then lays the pressed cell on top.
+	void update(const BoardSnapshot& snapshot, std::optional<std::size_t> pressedCellIndex);
 	void render(sf::RenderTarget& target) const;
-	void makeDirty() { dirty_ = true; }
+
+	// Time spent by the last update, zero if it had nothing to do.
+	// Only measured while profiling, clocks are not free.
+	struct Timings
+	{
+		std::chrono::nanoseconds encode; // Tiles into the snapshot, by the simulation thread
+		std::chrono::nanoseconds upload; // snapshot into the texture
+	};
+	void setProfiling(bool profiling) { profiling_ = profiling; }
+	const Timings& getTimings() const { return timings_; }
 
 private:
 
-	void flushScratch(std::size_t first, std::size_t count);
+	void resize(const Vec2s& size);
+	void uploadRows(const BoardSnapshot& snapshot, std::size_t firstRow, std::size_t lastRow);
+	void uploadTexelOf(const BoardSnapshot& snapshot, std::size_t index, bool pressed);
 
 private:
 
 	sf::VertexArray boardQuad_;
 	sf::Texture stateTexture_;
-	std::array<std::uint8_t, 512> scratch_;
+	Vec2s size_;
+	std::uint64_t uploadedSequence_;
+	std::optional<std::size_t> pressedCellIndex_; // laid on the texture
 
 	sf::Shader shader_;
-	bool dirty_;
+	bool profiling_;
+	Timings timings_;
 };
@@ -0,0 +1,51 @@
+#pragma once
+#include "Board.h"
+#include "GameLogic.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * What the main thread sees of a game the simulation thread plays: the board
+ * already turned into Tiles, and the few figures the interface shows. Filled
+ * by the writer, then handed over whole through a TripleBuffer and only read.
+ */
+struct BoardSnapshot
+{
+	// Sound of the last action that changed something
+	enum class Feedback : std::uint8_t
+	{
+		None,
+		Flag,
+		Open,
+		Lost,
+		Won
+	};
+
+	std::uint64_t sequence = 0; // counts the snapshots published, 0 before the first
+
+	// BoardEncoder output, padded with Unopened up to whole rows of the state
+	// texture. The pressed cell is left out: it follows the mouse, not the game.
+	std::vector<std::uint8_t> tiles;
+	// Tiles changed since the snapshot the renderer last uploaded, maybe more.
+	Board::Extent changed = {};
+	std::chrono::nanoseconds encodeTime = {};
+
+	Vec2s size = {};
+	std::size_t mineCount = 0, flagCount = 0, openCount = 0;
+	GameLogic::State state = GameLogic::Empty;
+	Board::Counters counters = {};
+
+	Feedback feedback = Feedback::None;
+	std::uint64_t feedbackSequence = 0; // of the snapshot the feedback came with
+
+	// The oldest click the renderer has not uploaded yet: when its event was
+	// taken from the window, and when the simulation was done playing it.
+	// Zero times if there is none.
+	struct Click
+	{
+		std::chrono::steady_clock::time_point input, applied;
+	};
+	Click click = {};
+};
@@ -23,9 +23,9 @@ void GameControls::operator()(const WorldEvent::Pressed& event)
 	case sf::Mouse::Button::Left:
 	case sf::Mouse::Button::Right:
 	{
-		auto& board = event.app.getGame().getBoard();
+		const Vec2s& size = event.app.getGame().getSnapshot().size;
 		auto coo = toCellCoordinates(event.position);
-		if (coo && board.areCoordinatesValid(*coo))
+		if (coo && coo->x < size.x && coo->y < size.y)
 		{
 			event.app.getGame().setPressedCell(*coo);
 		}
@@ -44,7 +44,6 @@ void GameControls::operator()(const WorldEvent::Released& event)
 		auto pressedCell = event.app.getGame().getPressedCell();
 		event.app.getGame().setPressedCell(std::nullopt);
 
-		auto& board = event.app.getGame().getBoard();
 		auto coo = toCellCoordinates(event.position);
 
 		// Only continue if we release the mouse on the previously pressed cell
@@ -52,32 +51,31 @@ void GameControls::operator()(const WorldEvent::Released& event)
 			return;
 
 		if (event.button == sf::Mouse::Button::Right)
-		{
-			auto flags = board.getFlagCount();
-			event.app.getGame().flag(*coo);
-			if (flags != board.getFlagCount())
-				event.app.getAudio().play(Resources::Sounds::click2);
-			return;
-		}
-
-		auto opened = board.getOpenCount();
-		event.app.getGame().open(*coo);
-		if (opened != board.getOpenCount())
-		{
-			auto& game = event.app.getGame();
-			if (game.isGameOver())
-			{
-				event.app.getAudio().play(
-					game.isLost()
-					? Resources::Sounds::explosion
-					: Resources::Sounds::victory);
-			}
-			else
-			{
-				event.app.getAudio().play(Resources::Sounds::click1);
-			}
-		}
+			event.app.getGame().flag(*coo, event.time);
+		else
+			event.app.getGame().open(*coo, event.time);
 	}
 	break;
 	}
 }
+
+void GameControls::play(Audio& audio, BoardSnapshot::Feedback feedback)
+{
+	switch (feedback)
+	{
+	case BoardSnapshot::Feedback::Flag:
+		audio.play(Resources::Sounds::click2);
+		break;
+	case BoardSnapshot::Feedback::Open:
+		audio.play(Resources::Sounds::click1);
+		break;
+	case BoardSnapshot::Feedback::Lost:
+		audio.play(Resources::Sounds::explosion);
+		break;
+	case BoardSnapshot::Feedback::Won:
+		audio.play(Resources::Sounds::victory);
+		break;
+	default:
+		break;
+	}
+}
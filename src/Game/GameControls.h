@@ -1,8 +1,15 @@
 #pragma once
+#include "BoardSnapshot.h"
 #include "Core/AppEvent.h"
 
+class Audio;
+
 struct GameControls
 {
 	void operator()(const WorldEvent::Pressed& event);
 	void operator()(const WorldEvent::Released& event);
+
+	// Actions are played on the simulation thread: their sound comes once
+	// their outcome is known, a frame or more after the click.
+	static void play(Audio& audio, BoardSnapshot::Feedback feedback);
 };
@@ -0,0 +1,139 @@
+#include "GameLogic.h"
+#include "Autosave.h"
+#include "Utils/MyRandom.h"
+#include <algorithm>
+
+GameLogic::GameLogic()
+	: state_(Empty)
+	, runningBombCount_(0)
+	, autosave_(nullptr)
+	, jobs_(nullptr)
+{}
+
+void GameLogic::resize(const Vec2s& size)
+{
+	if (!board_.isSizeValid(size))
+		return;
+
+	board_.resize(size);
+	runningBombIndexes_.clear();
+	state_ = Empty;
+}
+
+void GameLogic::setMineCount(std::size_t mineCount)
+{
+	if (mineCount > board_.getMaxNumberOfMines())
+		return;
+
+	board_.setMineCount(mineCount);
+}
+
+void GameLogic::restart(std::uint64_t seed)
+{
+	// If resize was not called once, then the size is invalid (0, 0)
+	if (!board_.isSizeValid(board_.getSize()))
+	{
+		state_ = Empty;
+		return;
+	}
+
+	random_.seed(seed);
+	board_.resetCounters();
+	board_.clear();
+	board_.placeMines(random_, jobs_);
+	// Indexes of the previous game no longer point to mines
+	runningBombIndexes_.clear();
+	state_ = Ready;
+}
+
+bool GameLogic::open(std::size_t index)
+{
+	if (!board_.isIndexValid(index))
+		return false;
+
+	if (state_ == Ready)
+	{
+		// First click
+		std::size_t moved = board_.makeSafe(index, random_);
+		if (autosave_ && moved != index)
+			autosave_->moveMine(index, moved);
+		state_ = Playing;
+		randomizeRunningBombIndexes();
+		if (autosave_)
+		{
+			for (std::size_t bomb : runningBombIndexes_)
+				autosave_->pickRunningBomb(bomb);
+		}
+	}
+
+	if (state_ != Playing)
+		return false;
+
+	std::size_t openCount = board_.getOpenCount();
+	bool mineOpened = board_.open(index);
+	if (autosave_)
+		autosave_->open(index);
+
+	if (mineOpened)
+	{
+		state_ = Lost;
+	}
+	else if (board_.isWon())
+	{
+		state_ = Won;
+	}
+	else if (openCount < board_.getOpenCount())
+	{
+		// Move the mine at each revealing click
+		for (auto& index : runningBombIndexes_)
+		{
+			std::size_t moved = board_.moveMine(index, random_);
+			if (autosave_ && moved != index)
+				autosave_->moveMine(index, moved);
+			index = moved;
+		}
+	}
+	return true;
+}
+
+bool GameLogic::flag(std::size_t index)
+{
+	if (state_ != Ready && state_ != Playing)
+		return false;
+
+	if (!board_.isIndexValid(index))
+		return false;
+
+	board_.flag(index);
+	if (autosave_)
+		autosave_->flag(index);
+	return true;
+}
+
+void GameLogic::resume(Board&& board, State state, std::size_t runningBombCount, std::vector<std::size_t>&& runningBombIndexes)
+{
+	board_ = std::move(board);
+	random_.seed(randomSeed());
+	state_ = state;
+	runningBombCount_ = runningBombCount;
+	runningBombIndexes_ = std::move(runningBombIndexes);
+}
+
+void GameLogic::randomizeRunningBombIndexes()
+{
+	std::size_t minesLeftToIterate = board_.getMineCount();
+	runningBombIndexes_.assign(std::min(runningBombCount_, minesLeftToIterate), 0);
+
+	std::size_t minesLeftToChoose = runningBombIndexes_.size();
+
+	auto& cells = board_.getCells();
+	for (std::size_t i = 0; i < cells.size() && minesLeftToChoose; ++i)
+	{
+		if (!cells[i].mined)
+			continue;
+
+		if (randomBelow(random_, minesLeftToIterate) < minesLeftToChoose)
+			runningBombIndexes_[--minesLeftToChoose] = i;
+		--minesLeftToIterate;
+	}
+}
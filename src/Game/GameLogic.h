@@ -0,0 +1,77 @@
+#pragma once
+#include "Board.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+class Autosave;
+class JobSystem;
+
+/*
+ * Rules of the game on top of the Board: first click safety, running bombs,
+ * win and lose conditions. Knows nothing of time, input or rendering, so
+ * games can be played headless.
+ *
+ * All the randomness of a game comes from the seed it was restarted with:
+ * the same seed and the same actions always lead to the same game, whatever
+ * the thread it is played on. It draws from a generator of its own.
+ */
+class GameLogic
+{
+public:
+
+	enum State : std::uint8_t
+	{
+		Empty = 0, // The board is not setup
+		Ready,     // Until first click
+		Playing,   // After first click until lose or win cond
+		Lost,
+		Won
+	};
+
+	GameLogic();
+
+	const Board& getBoard() const { return board_; }
+	Board::Extent takeChanges() { return board_.takeChanges(); }
+	Board::Snapshot takeSnapshot() { return board_.takeSnapshot(); }
+	State getState() const { return state_; }
+	bool isGameOver() const { return state_ == Lost || state_ == Won; }
+
+	void resize(const Vec2s& size);
+	void setMineCount(std::size_t mineCount);
+
+	// Requested count, clamped to the mine count at the first click
+	void setRunningBombCount(std::size_t count) { runningBombCount_ = count; }
+	std::size_t getRunningBombCount() const { return runningBombCount_; }
+	// Only filled while playing
+	const std::vector<std::size_t>& getRunningBombIndexes() const { return runningBombIndexes_; }
+
+	void restart(std::uint64_t seed);
+
+	// Opening an opened cell chords it. Both return false if the game does
+	// not take the action at all: not started, over, or out of the board.
+	bool open(std::size_t index);
+	bool flag(std::size_t index);
+
+	// Takes over a game from a save. Its randomness no longer follows a seed.
+	void resume(Board&& board, State state, std::size_t runningBombCount, std::vector<std::size_t>&& runningBombIndexes);
+
+	// Actions and mine moves are journaled into it, if not null.
+	void setAutosave(Autosave* autosave) { autosave_ = autosave; }
+	// Large boards get their mines placed on it, if not null.
+	void setJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+
+private:
+
+	void randomizeRunningBombIndexes();
+
+private:
+
+	Board board_;
+	std::mt19937_64 random_;
+	State state_;
+	std::size_t runningBombCount_;
+	std::vector<std::size_t> runningBombIndexes_;
+	Autosave* autosave_;
+	JobSystem* jobs_;
+};
@@ -1,10 +1,10 @@
 #include "GameUI.h"
 #include "Core/App.h"
 #include "Game/Resources.h"
+#include "Game/SaveFile.h"
 #include "Menus/MainMenu.h"
 #include "UI/UITarget.h"
 #include <format>
-#include <iterator>
 
 namespace
 {
@@ -12,11 +12,29 @@ namespace
 constexpr int SCREEN_PADDING = 5;
 constexpr sf::Vector2i BUTTON_SIZE = {150, 28};
 
+constexpr std::string_view SAVE_TEXT = "Save";
+constexpr std::string_view SAVED_TEXT = "Saved";
+constexpr std::string_view SAVING_TEXT = "Saving...";
+constexpr std::string_view SAVE_FAILED_TEXT = "Save failed!";
+
+std::string_view getSaveText(Minesweeper::SaveStatus status)
+{
+	switch (status)
+	{
+	case Minesweeper::SaveStatus::None: return SAVE_TEXT;
+	case Minesweeper::SaveStatus::Saving: return SAVING_TEXT;
+	case Minesweeper::SaveStatus::Saved: return SAVED_TEXT;
+	case Minesweeper::SaveStatus::Failed: return SAVE_FAILED_TEXT;
+	}
+	return SAVE_TEXT;
+}
+
 }
 
 GameUI::GameUI(App& app)
 	: game_(app.getGame())
 	, restartBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Restart"}
+	, saveBtn_{.rect = {{}, BUTTON_SIZE}, .text = SAVE_TEXT}
 	, mainMenuBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Main Menu"}
 	, resetCameraBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Reset Camera"}
 {
@@ -43,6 +61,12 @@ UIEvent::Result GameUI::operator()(const UIEvent::Resized& event)
 		SCREEN_PADDING
 	};
 
+	saveBtn_.rect.position =
+	{
+		event.newSize.x - SCREEN_PADDING - saveBtn_.rect.size.x,
+		SCREEN_PADDING * 2 + restartBtn_.rect.size.y
+	};
+
 	mainMenuBtn_.rect.position =
 	{
 		SCREEN_PADDING,
@@ -64,6 +88,7 @@ UIEvent::Result GameUI::operator()(const UIEvent::Pressed& event)
 		       event.position,
 		       {
 			       restartBtn_,
+			       saveBtn_,
 			       mainMenuBtn_,
 			       resetCameraBtn_
 		       })
@@ -77,6 +102,23 @@ UIEvent::Result GameUI::operator()(const UIEvent::Released& event)
 	{
 		event.app.getGame().restart();
 	}
+	else if (tracker_.isClicked(saveBtn_, event.position))
+	{
+		// Written in the background, one at a time: they would share the file
+		Minesweeper& game = event.app.getGame();
+		if (game.getSaveStatus() != Minesweeper::SaveStatus::Saving)
+		{
+			std::uint64_t ticket = game.beginSave();
+			if (auto data = game.takeSaveData())
+			{
+				event.app.runInBackground(
+					[contents = std::move(*data)] { return SaveFile::save(SaveFile::DEFAULT_PATH, contents.board, contents.meta); },
+					[&game, ticket](bool saved) { game.finishSave(ticket, saved); });
+			}
+			else
+				game.finishSave(ticket, false);
+		}
+	}
 	else if (tracker_.isClicked(mainMenuBtn_, event.position))
 	{
 		event.app.submitCommand<SwapUI>(SwapUI::DEFAULT<MainMenu>);
@@ -93,30 +135,32 @@ UIEvent::Result GameUI::operator()(const UIEvent::Released& event)
 
 void GameUI::render(UITarget& target) const
 {
-	auto& board = game_.getBoard();
-	std::make_signed_t<std::size_t> minesLeft = board.getMineCount() - board.getFlagCount();
+	const BoardSnapshot& snapshot = game_.getSnapshot();
+	std::make_signed_t<std::size_t> minesLeft = snapshot.mineCount - snapshot.flagCount;
 	float bestTime = std::numeric_limits<float>::signaling_NaN(); // TODO
 	auto time = game_.getPlayingTime().asMicroseconds() / 1'000'000;
 
-	gameString_.clear();
-	std::format_to(
-		std::back_inserter(gameString_),
+	auto result = std::format_to_n(
+		gameString_.data(),
+		gameString_.size(),
 		"Mines left: {}\nBest time: {}s\nTime: {}s",
 		minesLeft,
 		bestTime,
 		time);
-	gameText_.string = gameString_;
+	gameText_.string = {gameString_.data(), std::size_t(result.out - gameString_.data())};
 
 	target.draw(gameText_);
 	target.draw(resetCameraBtn_);
 	target.draw(mainMenuBtn_);
 	target.draw(restartBtn_);
+	saveBtn_.text = getSaveText(game_.getSaveStatus());
+	target.draw(saveBtn_);
 }
 
 void GameUI::centerBoardOnView(App& app) const
 {
-	auto& board = game_.getBoard();
-	sf::Vector2f size = {float(board.getSize().x), float(board.getSize().y)};
+	const Vec2s& boardSize = game_.getSnapshot().size;
+	sf::Vector2f size = {float(boardSize.x), float(boardSize.y)};
 	sf::Vector2f margin = {1.f, 1.f};
 	app.centerView({-margin, size + margin * 2.f});
 }
@@ -3,7 +3,7 @@
 #include "UI/Button.h"
 #include "UI/Text.h"
 #include "UI/ClickTracker.h"
-#include <string>
+#include <array>
 
 class App;
 class Minesweeper;
@@ -28,8 +28,10 @@ private:
 private:
 
 	Minesweeper& game_;
-	mutable std::string gameString_;
+	mutable std::array<char, 96> gameString_; // formatted in place, every frame
 	mutable Text gameText_;
-	Button restartBtn_, mainMenuBtn_, resetCameraBtn_;
+	Button restartBtn_;
+	mutable Button saveBtn_; // labelled with the save status, every frame
+	Button mainMenuBtn_, resetCameraBtn_;
 	ClickTracker tracker_;
 };
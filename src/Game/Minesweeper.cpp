@@ -1,14 +1,56 @@
 #include "Minesweeper.h"
+#include "SaveFile.h"
+#include "Tile.h"
 #include "Utils/MyRandom.h"
+#include "Utils/PageArena.h"
+#include "Utils/Trace.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
 
 Minesweeper::Minesweeper()
 	: rendering_(false)
-	, state_{}
 	, rotationSpeed_{}
-	, runningBombCount_{}
+	, recording_(false)
+	, saveStatus_(SaveStatus::None)
+	, saveTicket_(0)
+	, submitted_(0)
+	, completed_(0)
+	, staleTiles_{}
+	, unseen_{}
+	, unseenCount_(0)
+	, published_(0)
+	, lastFeedback_(BoardSnapshot::Feedback::None)
+	, lastFeedbackSequence_(0)
+	, batchClick_{}
+	, uploaded_(0)
+	, feedbackHeard_(0)
+	, feedback_(BoardSnapshot::Feedback::None)
+	, lastClickTimed_{}
 {
 	clock_.reset();
+	logic_.setAutosave(&autosave_);
+	simulation_ = std::jthread([this](std::stop_token stop) { simulate(stop); });
+}
+
+Minesweeper::~Minesweeper()
+{
+	sync();
+	// Wakes the simulation up to find it is stopped, the thread joins below
+	simulation_.request_stop();
+	submitted_.fetch_add(1, std::memory_order_release);
+	submitted_.notify_one();
+	simulation_.join();
+
+	saveReplay();
+}
+
+sf::Time Minesweeper::getPlayingTime() const
+{
+	std::scoped_lock lock(clockMutex_);
+	return playingTimeOffset_ + clock_.getElapsedTime();
 }
 
 void Minesweeper::setEasy()
@@ -29,100 +71,155 @@ void Minesweeper::setHard()
 	setMineCount(99);
 }
 
+Minesweeper::Footprint Minesweeper::getFootprint(const Vec2s& size)
+{
+	// Next to the board: the chunks autosave snapshots keep, the layers a save
+	// packs, one scratch layer and three sections at most, and the tiles of
+	// the board snapshots.
+	std::uint64_t cellCount = std::uint64_t(size.x) * size.y;
+	std::uint64_t layerBytes = Board::getLayerWordCount(size) * sizeof(std::uint64_t);
+	std::uint64_t tileBytes = TripleBuffer<BoardSnapshot>::SLOT_COUNT * std::uint64_t(BoardRenderer::getTileCount(size));
+	return
+	{
+		.hostBytes = Board::getMemoryFootprint(size) + cellCount * sizeof(Cell) + 4 * layerBytes + tileBytes,
+		.gpuBytes = BoardRenderer::getStateTextureBytes(size),
+		.textureRows = BoardRenderer::getStateTextureSize(size).y,
+	};
+}
+
 void Minesweeper::resize(const Vec2s& size)
 {
-	if (!board_.isSizeValid(size))
+	if (!Board::isSizeValid(size))
 		return;
 
-	board_.resize(size);
-	renderer_.resize(board_);
-	runningBombIndexes_.clear();
-	state_ = Empty;
-	renderer_.makeDirty();
+	sync();
+	saveReplay();
+	// What the arena kept was sized for the previous board
+	PageArena::trim();
+	logic_.resize(size);
+	publishSetup();
 }
 
 void Minesweeper::setMineCount(std::size_t mineCount)
 {
-	if (mineCount > board_.getMaxNumberOfMines())
-		return;
-
-	board_.setMineCount(mineCount);
+	sync();
+	logic_.setMineCount(mineCount);
+	publishSetup();
 }
 
 void Minesweeper::restart()
 {
-	// If resize was not called once, then the size is invalid (0, 0)
-	if (!board_.isSizeValid(board_.getSize()))
+	MPP_TRACE_SCOPE("Minesweeper::restart");
+	sync();
+	saveReplay();
+
+	saveStatus_ = SaveStatus::None;
+	++saveTicket_;
+
+	std::uint64_t seed = randomSeed();
+	logic_.restart(seed);
 	{
-		state_ = Empty;
-		return;
+		std::scoped_lock lock(clockMutex_);
+		clock_.reset();
+		playingTimeOffset_ = sf::Time::Zero;
 	}
+	publishSetup();
+	if (logic_.getState() == GameLogic::Empty)
+		return;
 
-	board_.clear();
-	board_.placeMines();
-	// Indexes of the previous game no longer point to mines
-	runningBombIndexes_.clear();
-	clock_.reset();
-	state_ = Ready;
-	renderer_.makeDirty();
+	replay_.begin(seed);
+	recording_ = true;
+	autosave_.begin(logic_.takeSnapshot(), makeMeta());
 }
 
-void Minesweeper::open(const Vec2s& coordinates)
+void Minesweeper::open(const Vec2s& coordinates, std::chrono::steady_clock::time_point input)
 {
-	if (state_ == Empty)
+	// The simulation never empties the board, the snapshot is enough to tell
+	if (getSnapshot().state == GameLogic::Empty)
 		restart();
 
-	if (!board_.areCoordinatesValid(coordinates))
+	const Vec2s& size = getSnapshot().size;
+	if (coordinates.x >= size.x || coordinates.y >= size.y)
 		return;
 
-	std::size_t index = board_.toIndex(coordinates);
+	submit({Action::Open, coordinates.y * size.x + coordinates.x, input});
+}
 
-	if (state_ == Ready)
-	{
-		// First click
-		board_.makeSafe(index);
-		clock_.restart();
-		state_ = Playing;
-		randomizeRunningBombIndexes();
-	}
+void Minesweeper::flag(const Vec2s& coordinates, std::chrono::steady_clock::time_point input)
+{
+	if (getSnapshot().state == GameLogic::Empty)
+		restart();
 
-	if (state_ != Playing)
+	const Vec2s& size = getSnapshot().size;
+	if (coordinates.x >= size.x || coordinates.y >= size.y)
 		return;
 
-	std::size_t openCount = board_.getOpenCount();
-	if (board_.open(index))
-	{
-		state_ = Lost;
-		clock_.stop();
-	}
-	else if (board_.isWon())
-	{
-		state_ = Won;
-		clock_.stop();
-	}
-	else if (openCount < board_.getOpenCount())
-	{
-		// Move the mine at each revealing click
-		for (auto& index : runningBombIndexes_)
-			index = board_.moveMine(index);
-	}
-	renderer_.makeDirty();
+	submit({Action::Flag, coordinates.y * size.x + coordinates.x, input});
 }
 
-void Minesweeper::flag(const Vec2s& coordinates)
+bool Minesweeper::save(const std::filesystem::path& file) const
 {
-	if (state_ == Empty)
-		restart();
+	sync();
+	if (logic_.getState() == GameLogic::Empty)
+		return false;
 
-	if (state_ != Ready && state_ != Playing)
-		return;
+	return SaveFile::save(file, logic_.getBoard(), makeMeta());
+}
 
-	if (!board_.areCoordinatesValid(coordinates))
-		return;
+std::optional<Minesweeper::SaveData> Minesweeper::takeSaveData()
+{
+	sync();
+	if (logic_.getState() == GameLogic::Empty)
+		return std::nullopt;
+
+	return SaveData{.board = logic_.takeSnapshot(), .meta = makeMeta()};
+}
 
-	std::size_t index = board_.toIndex(coordinates);
-	board_.flag(index);
-	renderer_.makeDirty();
+void Minesweeper::finishSave(std::uint64_t ticket, bool saved)
+{
+	if (ticket == saveTicket_)
+		saveStatus_ = saved ? SaveStatus::Saved : SaveStatus::Failed;
+}
+
+bool Minesweeper::load(const std::filesystem::path& file)
+{
+	Board board;
+	SaveFile::Meta meta;
+	if (!SaveFile::load(file, board, meta) || meta.state < GameLogic::Ready || meta.state > GameLogic::Won)
+		return false;
+
+	sync();
+	resume(std::move(board), std::move(meta));
+	return true;
+}
+
+bool Minesweeper::recoverAutosave()
+{
+	Board board;
+	SaveFile::Meta meta;
+	bool mineOpened;
+	sync();
+	if (!autosave_.recover(board, meta, mineOpened) || meta.state < GameLogic::Ready || meta.state > GameLogic::Won)
+		return false;
+
+	// The snapshot state does not account for the replayed actions
+	if (meta.state == GameLogic::Ready || meta.state == GameLogic::Playing)
+	{
+		meta.state = mineOpened
+		             ? GameLogic::Lost
+		             : board.isWon()
+		               ? GameLogic::Won
+		               : board.getOpenCount()
+		                 ? GameLogic::Playing
+		                 : GameLogic::Ready;
+	}
+
+	// A finished game is not worth resuming
+	if (meta.state == GameLogic::Lost || meta.state == GameLogic::Won)
+		return false;
+
+	resume(std::move(board), std::move(meta));
+	return true;
 }
 
 void Minesweeper::dispatchWorldEvent(const WorldEvent& event)
@@ -133,27 +230,40 @@ void Minesweeper::dispatchWorldEvent(const WorldEvent& event)
 	}
 }
 
-void Minesweeper::update(float dt)
+void Minesweeper::step(float dt)
+{
+	stepRotation_ = sf::degrees(rotationSpeed_ * dt);
+	unshownRotation_ += stepRotation_;
+}
+
+bool Minesweeper::update(float alpha)
 {
-	frameRotation_ = sf::degrees(rotationSpeed_ * dt);
+	// Short of the last step by what the frame is not past it yet
+	frameRotation_ = unshownRotation_ - stepRotation_ * (1.f - alpha);
+	unshownRotation_ -= frameRotation_;
+
+	bool fresh = snapshots_.acquire();
+	const BoardSnapshot& snapshot = getSnapshot();
+	if (snapshot.feedbackSequence > feedbackHeard_)
+	{
+		feedbackHeard_ = snapshot.feedbackSequence;
+		feedback_ = snapshot.feedback;
+	}
 
 	std::optional<std::size_t> pressedCellIndex;
-	if (pressedCell_)
-		pressedCellIndex = board_.toIndex(*pressedCell_);
+	if (pressedCell_ && pressedCell_->x < snapshot.size.x && pressedCell_->y < snapshot.size.y)
+		pressedCellIndex = pressedCell_->y * snapshot.size.x + pressedCell_->x;
 
-	auto reveal = state_ == Lost
-	              ? BoardRenderer::Reveal::Lost
-	              : state_ == Won
-	                ? BoardRenderer::Reveal::Won
-	                : BoardRenderer::Reveal::None;
+	renderer_.update(snapshot, pressedCellIndex);
+	uploaded_.store(snapshot.sequence, std::memory_order_release);
 
-	BoardRenderer::State state
+	// Later snapshots may show the same click until they hear it was uploaded
+	if (fresh && snapshot.click.input > lastClickTimed_)
 	{
-		.reveal             = reveal,
-		.pressedCellIndex   = pressedCellIndex,
-		.runningMineIndexes = runningBombIndexes_
-	};
-	renderer_.update(board_, state);
+		lastClickTimed_ = snapshot.click.input;
+		uploadedClick_ = UploadedClick{snapshot.click, std::chrono::steady_clock::now()};
+	}
+	return fresh;
 }
 
 void Minesweeper::render(sf::RenderTarget& target) const
@@ -161,8 +271,9 @@ void Minesweeper::render(sf::RenderTarget& target) const
 	if (!rendering_)
 		return;
 
+	const Vec2s& size = getSnapshot().size;
 	sf::View view = target.getView();
-	sf::Vector2f center = {board_.getSize().x / 2.f, board_.getSize().y / 2.f};
+	sf::Vector2f center = {size.x / 2.f, size.y / 2.f};
 	sf::Vector2f offset = center - view.getCenter();
 	view.move(offset - offset.rotatedBy(frameRotation_));
 	view.rotate(frameRotation_);
@@ -179,34 +290,318 @@ void Minesweeper::resetParameters()
 	setRunningBombCount(0);
 }
 
+bool Minesweeper::isSimulating() const
+{
+	return completed_.load(std::memory_order_relaxed) != submitted_.load(std::memory_order_relaxed)
+	       || snapshots_.hasFresh();
+}
+
+std::optional<sf::Time> Minesweeper::getTimeToNextTick() const
+{
+	if (!rendering_)
+		return std::nullopt;
+	{
+		std::scoped_lock lock(clockMutex_);
+		if (!clock_.isRunning())
+			return std::nullopt;
+	}
+
+	// The time is shown in whole seconds
+	constexpr std::int64_t second = 1'000'000;
+	return sf::microseconds(second - getPlayingTime().asMicroseconds() % second);
+}
+
+void Minesweeper::setRotationSpeed(float speed)
+{
+	sync();
+	rotationSpeed_ = speed;
+	stepRotation_ = unshownRotation_ = sf::Angle::Zero;
+}
+
 void Minesweeper::setPressedCell(std::optional<Vec2s> coordinates)
 {
 	pressedCell_ = coordinates;
-	renderer_.makeDirty();
 }
 
-void Minesweeper::setRunningBombCount(std::size_t count)
+SaveFile::Meta Minesweeper::makeMeta() const
+{
+	return
+	{
+		.state = std::uint8_t(logic_.getState()),
+		.playingTimeUs = std::uint64_t(getPlayingTime().asMicroseconds()),
+		.rotationSpeed = rotationSpeed_,
+		.runningBombCount = logic_.getRunningBombCount(),
+		.runningBombIndexes = logic_.getRunningBombIndexes(),
+		.sequence = autosave_.getSequence(),
+		.gameId = autosave_.getGameId()
+	};
+}
+
+void Minesweeper::resume(Board&& board, SaveFile::Meta&& meta)
+{
+	saveReplay();
+	recording_ = false;
+	saveStatus_ = SaveStatus::None;
+	++saveTicket_;
+
+	logic_.resume(
+		std::move(board),
+		GameLogic::State(meta.state),
+		std::size_t(meta.runningBombCount),
+		std::move(meta.runningBombIndexes));
+	setRotationSpeed(meta.rotationSpeed);
+	pressedCell_.reset();
+
+	// The clock only runs while playing, on top of the time already played
+	{
+		std::scoped_lock lock(clockMutex_);
+		playingTimeOffset_ = sf::microseconds(std::int64_t(meta.playingTimeUs));
+		clock_.reset();
+		if (logic_.getState() == GameLogic::Playing)
+			clock_.start();
+	}
+
+	publishSetup();
+	autosave_.begin(logic_.takeSnapshot(), makeMeta());
+}
+
+void Minesweeper::autosaveIfDue()
+{
+	if (autosave_.isSnapshotDue())
+		autosave_.snapshot(logic_.takeSnapshot(), makeMeta());
+}
+
+void Minesweeper::updateClock(GameLogic::State previous)
+{
+	std::scoped_lock lock(clockMutex_);
+	if (previous == GameLogic::Ready && logic_.getState() != GameLogic::Ready)
+		clock_.restart();
+	if (logic_.isGameOver())
+		clock_.stop();
+}
+
+void Minesweeper::record(Replay::Action action, std::size_t index)
+{
+	if (!recording_)
+		return;
+
+	replay_.record(action, index, std::uint64_t(getPlayingTime().asMilliseconds()));
+	if (logic_.isGameOver())
+		saveReplay();
+}
+
+void Minesweeper::saveReplay()
+{
+	if (!recording_ || !replay_.getEventCount())
+		return;
+
+	recording_ = false;
+	const Board& board = logic_.getBoard();
+	replay_.finish(
+		{
+			.size = board.getSize(),
+			.mineCount = board.getMineCount(),
+			.runningBombCount = logic_.getRunningBombIndexes().size()
+		},
+		{
+			.state = std::uint8_t(logic_.getState()),
+			.openCount = board.getOpenCount(),
+			.flagCount = board.getFlagCount()
+		});
+
+	// Named after the seed, a few hundred bytes written once per game
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016" PRIx64, replay_.getSeed());
+	std::filesystem::path file = Replay::DEFAULT_DIRECTORY / name;
+	file += Replay::EXTENSION;
+
+	std::error_code error;
+	std::filesystem::create_directories(Replay::DEFAULT_DIRECTORY, error);
+	replay_.save(file);
+}
+
+void Minesweeper::sync() const
+{
+	std::uint64_t submitted = submitted_.load(std::memory_order_relaxed);
+	for (std::uint64_t completed; (completed = completed_.load(std::memory_order_acquire)) != submitted;)
+		completed_.wait(completed, std::memory_order_acquire);
+}
+
+void Minesweeper::submit(const Action& action)
 {
-	// Clamped at randomization time, the mine count may still change
-	runningBombCount_ = count;
+	// A full queue is a simulation far behind, no use piling more up
+	if (!actions_.tryPush(action))
+	{
+		sync();
+		[[maybe_unused]] bool pushed = actions_.tryPush(action);
+		assert(pushed);
+	}
+	submitted_.fetch_add(1, std::memory_order_release);
+	submitted_.notify_one();
+}
+
+void Minesweeper::simulate(std::stop_token stop)
+{
+	std::uint64_t completed = 0;
+	while (true)
+	{
+		submitted_.wait(completed, std::memory_order_acquire);
+		if (stop.stop_requested())
+			return;
+
+		// Everything sent meanwhile goes into the same snapshot
+		std::uint64_t submitted = submitted_.load(std::memory_order_acquire);
+		Board::Extent changes{};
+		for (; completed < submitted; ++completed)
+		{
+			Action action;
+			[[maybe_unused]] bool popped = actions_.tryPop(action);
+			assert(popped);
+			apply(action, changes);
+		}
+		publishSnapshot(changes);
+
+		completed_.store(completed, std::memory_order_release);
+		completed_.notify_all();
+	}
+}
+
+void Minesweeper::apply(const Action& action, Board::Extent& changes)
+{
+	const Board& board = logic_.getBoard();
+	auto previous = logic_.getState();
+	std::size_t openCount = board.getOpenCount();
+	std::size_t flagCount = board.getFlagCount();
+
+	BoardSnapshot::Feedback feedback = BoardSnapshot::Feedback::None;
+	if (action.type == Action::Flag)
+	{
+		MPP_TRACE_SCOPE("Minesweeper::flag", "index", std::int64_t(action.index));
+		if (!logic_.flag(action.index))
+			return;
+
+		record(Replay::Flag, action.index);
+		if (flagCount != board.getFlagCount())
+			feedback = BoardSnapshot::Feedback::Flag;
+	}
+	else
+	{
+		MPP_TRACE_SCOPE("Minesweeper::open", "index", std::int64_t(action.index));
+		bool chord = board.getCellAt(action.index).opened;
+		if (!logic_.open(action.index))
+			return;
+
+		updateClock(previous);
+		record(chord ? Replay::Chord : Replay::Open, action.index);
+		if (openCount != board.getOpenCount())
+		{
+			feedback = logic_.getState() == GameLogic::Lost
+			           ? BoardSnapshot::Feedback::Lost
+			           : logic_.getState() == GameLogic::Won
+			             ? BoardSnapshot::Feedback::Won
+			             : BoardSnapshot::Feedback::Open;
+		}
+	}
+
+	changes.merge(logic_.takeChanges());
+	// Game over reveals the mines, wherever they are
+	if (logic_.isGameOver() && previous != logic_.getState())
+		changes = {0, board.getCells().size()};
+
+	if (feedback != BoardSnapshot::Feedback::None)
+	{
+		lastFeedback_ = feedback;
+		lastFeedbackSequence_ = published_ + 1;
+	}
+	// Clicks of the same batch show together, the first waited the longest
+	if (action.input != std::chrono::steady_clock::time_point{} && batchClick_.input == std::chrono::steady_clock::time_point{})
+		batchClick_ = {action.input, std::chrono::steady_clock::now()};
+	autosaveIfDue();
 }
 
-void Minesweeper::randomizeRunningBombIndexes()
+void Minesweeper::publishSnapshot(Board::Extent changes)
 {
-	std::size_t minesLeftToIterate = board_.getMineCount();
-	runningBombIndexes_.assign(std::min(runningBombCount_, minesLeftToIterate), 0);
+	MPP_TRACE_SCOPE("Minesweeper::publishSnapshot");
+	using Clock = std::chrono::steady_clock;
+	auto encodeStart = Clock::now();
+
+	const Board& board = logic_.getBoard();
+	BoardSnapshot& snapshot = snapshots_.back();
+	std::size_t cellCount = board.getCells().size();
 
-	std::size_t minesLeftToChoose = runningBombIndexes_.size();
+	// Each slot catches up on what changed since it was last written
+	for (Board::Extent& stale : staleTiles_)
+		stale.merge(changes);
+	Board::Extent& stale = staleTiles_[snapshots_.getBackIndex()];
 
-	auto& cells = board_.getCells();
-	for (std::size_t i = 0; i < cells.size() && minesLeftToChoose; ++i)
+	std::size_t tileCount = BoardRenderer::getTileCount(board.getSize());
+	if (snapshot.tiles.size() != tileCount)
 	{
-		if (!cells[i].mined)
-			continue;
+		snapshot.tiles.assign(tileCount, std::uint8_t(Resources::Textures::Tile::Unopened));
+		stale = {0, cellCount};
+	}
 
-		std::uniform_int_distribution<std::size_t> dist(0, minesLeftToIterate - 1);
-		if (dist(gen) < minesLeftToChoose)
-			runningBombIndexes_[--minesLeftToChoose] = i;
-		--minesLeftToIterate;
+	if (!stale.isEmpty())
+	{
+		auto reveal = logic_.getState() == GameLogic::Lost
+		              ? BoardEncoder::Reveal::Lost
+		              : logic_.getState() == GameLogic::Won
+		                ? BoardEncoder::Reveal::Won
+		                : BoardEncoder::Reveal::None;
+
+		BoardEncoder::State state
+		{
+			.reveal             = reveal,
+			.pressedCellIndex   = std::nullopt,
+			.runningMineIndexes = logic_.getRunningBombIndexes()
+		};
+		BoardEncoder::encode(board, state, stale.first, {snapshot.tiles.data() + stale.first, stale.last - stale.first});
+		stale = {};
 	}
+
+	// The renderer needs every change since the last snapshot it uploaded, not
+	// only those since the last one published: it may have skipped some.
+	std::uint64_t uploaded = uploaded_.load(std::memory_order_acquire);
+	auto seen = std::find_if(unseen_.begin(), unseen_.begin() + unseenCount_,
+		[uploaded](const Published& published) { return published.sequence > uploaded; });
+	unseenCount_ = std::size_t(std::move(seen, unseen_.begin() + unseenCount_, unseen_.begin()) - unseen_.begin());
+	if (unseenCount_ == MAX_UNSEEN)
+	{
+		// A renderer that long behind gets a coarser range
+		unseen_[1].changed.merge(unseen_[0].changed);
+		if (unseen_[1].click.input == Clock::time_point{})
+			unseen_[1].click = unseen_[0].click;
+		std::move(unseen_.begin() + 1, unseen_.end(), unseen_.begin());
+		--unseenCount_;
+	}
+	unseen_[unseenCount_++] = {published_ + 1, changes, std::exchange(batchClick_, {})};
+
+	snapshot.changed = {};
+	snapshot.click = {};
+	for (std::size_t i = 0; i < unseenCount_; ++i)
+	{
+		snapshot.changed.merge(unseen_[i].changed);
+		if (snapshot.click.input == Clock::time_point{})
+			snapshot.click = unseen_[i].click;
+	}
+
+	snapshot.sequence = ++published_;
+	snapshot.size = board.getSize();
+	snapshot.mineCount = board.getMineCount();
+	snapshot.flagCount = board.getFlagCount();
+	snapshot.openCount = board.getOpenCount();
+	snapshot.state = logic_.getState();
+	snapshot.counters = board.getCounters();
+	snapshot.feedback = lastFeedback_;
+	snapshot.feedbackSequence = lastFeedbackSequence_;
+	snapshot.encodeTime = Clock::now() - encodeStart;
+	snapshots_.publish();
+}
+
+void Minesweeper::publishSetup()
+{
+	// The whole board may have changed, and the caller reads it back at once
+	logic_.takeChanges();
+	publishSnapshot({0, logic_.getBoard().getCells().size()});
+	snapshots_.acquire();
 }
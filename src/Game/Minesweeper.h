@@ -1,37 +1,103 @@
 #pragma once
-#include "Board.h"
+#include "Autosave.h"
 #include "BoardRenderer.h"
+#include "BoardSnapshot.h"
 #include "GameControls.h"
+#include "GameLogic.h"
+#include "Replay.h"
+#include "Utils/MpscQueue.h"
+#include "Utils/NotCopyable.h"
+#include "Utils/NotMovable.h"
+#include "Utils/TripleBuffer.h"
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/System/Clock.hpp>
 #include <SFML/System/Time.hpp>
-
-class Minesweeper
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+/*
+ * A game on screen. Opening and flagging cells is played on a simulation
+ * thread of its own, so that a long cascade never holds the frame loop: input
+ * is still handled and the camera still moves. The main thread only sees the
+ * game through the snapshots the simulation publishes, and the renderer
+ * uploads them as they come.
+ *
+ * Everything else, setting a game up, saving and loading it, runs on the
+ * main thread once the simulation is done with the actions sent to it.
+ */
+class Minesweeper : NotCopyable, NotMovable
 {
 public:
 
 	Minesweeper();
 
-	const Board& getBoard() const { return board_; }
-	sf::Time getPlayingTime() const { return clock_.getElapsedTime(); }
-	bool isGameOver() const { return state_ == Lost || state_ == Won; }
-	bool isLost() const { return state_ == Lost; }
+	~Minesweeper(); // keeps the replay of the game left unfinished
+
+	// The last snapshot taken by update, or by a setup method. Main thread only.
+	const BoardSnapshot& getSnapshot() const { return snapshots_.front(); }
+	sf::Time getPlayingTime() const;
 
 	void setEasy();
 	void setMedium();
 	void setHard();
 
+	// Memory a game of that size takes, to turn down those that would not fit.
+	struct Footprint
+	{
+		std::uint64_t hostBytes;
+		std::uint64_t gpuBytes;
+		std::size_t textureRows; // of the state texture, bounded by the GL limit
+	};
+	static Footprint getFootprint(const Vec2s& size);
+
 	void resize(const Vec2s& size);
 	void setMineCount(std::size_t mineCount);
 
 	void restart();
-	void open(const Vec2s& coordinates);
-	void flag(const Vec2s& coordinates);
+	// Sent to the simulation, their outcome shows in a later snapshot. 'input'
+	// is the time of the event they come from, for clicks to be timed.
+	void open(const Vec2s& coordinates, std::chrono::steady_clock::time_point input = {});
+	void flag(const Vec2s& coordinates, std::chrono::steady_clock::time_point input = {});
+	// Sound of the actions played since the last call, once.
+	BoardSnapshot::Feedback takeFeedback() { return std::exchange(feedback_, BoardSnapshot::Feedback::None); }
+
+	// Nothing is saved before the board is set up. A failed load keeps the current game.
+	bool save(const std::filesystem::path& file) const;
+	bool load(const std::filesystem::path& file);
+
+	// What save writes, taken for another thread to write it. nullopt before
+	// the board is set up.
+	struct SaveData
+	{
+		Board::Snapshot board;
+		SaveFile::Meta meta;
+	};
+	std::optional<SaveData> takeSaveData();
+	// How the last save begun went, until another game replaces this one.
+	// Saves begun before that, or before the last, finish without a say.
+	enum class SaveStatus : std::uint8_t { None, Saving, Saved, Failed };
+	std::uint64_t beginSave() { saveStatus_ = SaveStatus::Saving; return ++saveTicket_; }
+	void finishSave(std::uint64_t ticket, bool saved);
+	SaveStatus getSaveStatus() const { return saveStatus_; }
+
+	// Resumes the game left unfinished by the previous run, if any.
+	bool recoverAutosave();
+	const Autosave::Stats& getAutosaveStats() const { sync(); return autosave_.getStats(); }
 
 public:
 
 	void dispatchWorldEvent(const WorldEvent& event);
-	void update(float dt);
+	// Animations advance by fixed steps of 'dt' seconds, whatever the frame
+	// rate. The frame shows them 'alpha' of a step past the one before last.
+	void step(float dt);
+	// True if it took a new snapshot, that the next frame has to show
+	bool update(float alpha);
 	void render(sf::RenderTarget& target) const;
 
 public:
@@ -42,39 +108,112 @@ public:
 	std::optional<Vec2s> getPressedCell() const { return pressedCell_; }
 	void setRendering(bool active) { rendering_ = active; }
 
-	void setRotationSpeed(float speed) { rotationSpeed_ = speed; }
+	// Something moves on screen every frame: the board spins, or the
+	// simulation has a snapshot coming.
+	bool isAnimating() const { return rendering_ && (rotationSpeed_ != 0.f || isSimulating()); }
+	bool isSimulating() const;
+	// Until the playing time shown changes, nullopt while the clock is stopped.
+	std::optional<sf::Time> getTimeToNextTick() const;
+
+	void setJobSystem(JobSystem* jobs) { sync(); logic_.setJobSystem(jobs); }
+	void setProfiling(bool profiling) { renderer_.setProfiling(profiling); }
+	const BoardRenderer::Timings& getRendererTimings() const { return renderer_.getTimings(); }
+	// The oldest click the snapshot taken by update showed, and when the
+	// renderer was done uploading it. Once per click, some are never seen:
+	// those sharing a snapshot with an older one.
+	struct UploadedClick
+	{
+		BoardSnapshot::Click click;
+		std::chrono::steady_clock::time_point uploaded;
+	};
+	std::optional<UploadedClick> takeUploadedClick() { return std::exchange(uploadedClick_, std::nullopt); }
+
+	void setRotationSpeed(float speed);
 	float getRotationSpeed() const { return rotationSpeed_; }
-	void setRunningBombCount(std::size_t count);
-	std::size_t getRunningBombCount() const { return runningBombCount_; }
+	void setRunningBombCount(std::size_t count) { sync(); logic_.setRunningBombCount(count); }
+	std::size_t getRunningBombCount() const { return logic_.getRunningBombCount(); }
 
 private:
 
-	void randomizeRunningBombIndexes();
+	struct Action
+	{
+		enum Type : std::uint8_t { Open, Flag } type;
+		std::size_t index;
+		std::chrono::steady_clock::time_point input;
+	};
+
+	// Main thread. Waits until the simulation is done with every action sent.
+	void sync() const;
+	void submit(const Action& action);
+	// Simulation thread
+	void simulate(std::stop_token stop);
+	void apply(const Action& action, Board::Extent& changes);
+	// Writer of the snapshots: the simulation thread, or the main thread in
+	// sync. Those published by the main thread are taken right away.
+	void publishSnapshot(Board::Extent changes);
+	void publishSetup();
+
+	SaveFile::Meta makeMeta() const;
+	void resume(Board&& board, SaveFile::Meta&& meta);
+	void autosaveIfDue();
+	void updateClock(GameLogic::State previous);
+	void record(Replay::Action action, std::size_t index);
+	void saveReplay();
 
 private:
 
-	Board board_;
+	// Simulation thread while actions are pending, main thread otherwise
+	GameLogic logic_;
 	BoardRenderer renderer_;
+	mutable std::mutex clockMutex_; // started and stopped by the simulation, read every frame
 	sf::Clock clock_;
+	sf::Time playingTimeOffset_; // time played before the game was loaded
 	std::optional<Vec2s> pressedCell_;
 	GameControls controls_;
 	bool rendering_;
 
-	enum : char
-	{
-		Empty = 0, // The board is not setup
-		Ready,     // Until first click
-		Playing,   // After first click until lose or win cond
-		Lost,
-		Won
-
-	} state_;
-
 	float rotationSpeed_;
-	sf::Angle frameRotation_;
-
-	// Requested count (game mode parameter), and the indexes of the
-	// running bombs, only filled while playing.
-	std::size_t runningBombCount_;
-	std::vector<std::size_t> runningBombIndexes_;
+	// The view is only ever turned by deltas: of the last step, of the steps
+	// it was not turned by yet, and of the frame to draw.
+	sf::Angle stepRotation_, unshownRotation_, frameRotation_;
+
+	// Games started here are replayable, loaded ones are not: the random
+	// numbers they drew before the save are lost.
+	Replay replay_;
+	bool recording_;
+
+	Autosave autosave_;
+	SaveStatus saveStatus_;
+	std::uint64_t saveTicket_;
+
+	static constexpr std::size_t ACTION_QUEUE_CAPACITY = 64;
+	MpscQueue<Action, ACTION_QUEUE_CAPACITY> actions_;
+	std::atomic<std::uint64_t> submitted_, completed_;
+
+	TripleBuffer<BoardSnapshot> snapshots_;
+	// Writer side. The tiles each slot is behind on, and the changes published
+	// since the snapshot the renderer uploaded, oldest first.
+	struct Published
+	{
+		std::uint64_t sequence;
+		Board::Extent changed;
+		BoardSnapshot::Click click;
+	};
+	static constexpr std::size_t MAX_UNSEEN = 8;
+	std::array<Board::Extent, TripleBuffer<BoardSnapshot>::SLOT_COUNT> staleTiles_;
+	std::array<Published, MAX_UNSEEN> unseen_;
+	std::size_t unseenCount_;
+	std::uint64_t published_;
+	BoardSnapshot::Feedback lastFeedback_;
+	std::uint64_t lastFeedbackSequence_;
+	BoardSnapshot::Click batchClick_; // the first of the actions to publish
+	// Reader side
+	std::atomic<std::uint64_t> uploaded_;
+	std::uint64_t feedbackHeard_;
+	BoardSnapshot::Feedback feedback_;
+	std::chrono::steady_clock::time_point lastClickTimed_;
+	std::optional<UploadedClick> uploadedClick_;
+
+	// Last: stopped first, it plays on everything above
+	std::jthread simulation_;
 };
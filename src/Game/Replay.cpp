@@ -0,0 +1,196 @@
+#include "Replay.h"
+#include "GameLogic.h"
+#include "Utils/MappedFile.h"
+#include "Utils/Varint.h"
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+
+constexpr std::uint32_t MAGIC = 0x5052504D; // "MPRP"
+constexpr std::uint32_t VERSION = 2;
+// Before large boards had their mines placed in parallel: the others still
+// come out of their seed the same.
+constexpr std::uint32_t SERIAL_PLACEMENT_VERSION = 1;
+
+struct Header
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t width, height;
+	std::uint64_t mineCount;
+	std::uint64_t runningBombCount;
+	std::uint64_t seed;
+	std::uint64_t eventCount;
+	std::uint64_t openCount;
+	std::uint64_t flagCount;
+	std::uint8_t state;
+};
+
+} // namespace
+
+void Replay::begin(std::uint64_t seed)
+{
+	seed_ = seed;
+	setup_ = {};
+	outcome_ = {};
+	events_.clear();
+	eventCount_ = 0;
+	lastTimeMs_ = 0;
+}
+
+void Replay::record(Action action, std::size_t index, std::uint64_t timeMs)
+{
+	// Time never goes back, a clock hiccup is recorded as simultaneous
+	std::uint64_t delta = timeMs > lastTimeMs_ ? timeMs - lastTimeMs_ : 0;
+	lastTimeMs_ += delta;
+
+	Varint::write(events_, delta);
+	Varint::write(events_, (std::uint64_t(index) << 2) | action);
+	++eventCount_;
+}
+
+void Replay::finish(const Setup& setup, const Outcome& outcome)
+{
+	setup_ = setup;
+	outcome_ = outcome;
+}
+
+bool Replay::save(const std::filesystem::path& file) const
+{
+	Header header{};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.width = setup_.size.x;
+	header.height = setup_.size.y;
+	header.mineCount = setup_.mineCount;
+	header.runningBombCount = setup_.runningBombCount;
+	header.seed = seed_;
+	header.eventCount = eventCount_;
+	header.openCount = outcome_.openCount;
+	header.flagCount = outcome_.flagCount;
+	header.state = outcome_.state;
+
+	// Written aside then swapped in, like saves
+	std::filesystem::path temp = file;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(events_.data()), std::streamsize(events_.size()));
+		// Checked once closed, the last buffer flushed
+		out.close();
+		if (out.fail())
+		{
+			std::error_code error;
+			std::filesystem::remove(temp, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, file, error);
+	return !error;
+}
+
+bool Replay::load(const std::filesystem::path& file)
+{
+	MappedFile mapped(file);
+	auto bytes = mapped.bytes();
+	if (bytes.size() < sizeof(Header))
+		return false;
+
+	Header header;
+	std::memcpy(&header, bytes.data(), sizeof(Header));
+	if (header.magic != MAGIC || (header.version != VERSION && header.version != SERIAL_PLACEMENT_VERSION))
+		return false;
+
+	Vec2s size = {std::size_t(header.width), std::size_t(header.height)};
+	if (!Board::isSizeValid(size) || header.mineCount >= size.x * size.y)
+		return false;
+	if (header.version == SERIAL_PLACEMENT_VERSION && Board::isPlacementParallel(size))
+		return false;
+
+	// Each event takes two bytes at least
+	auto events = bytes.subspan(sizeof(Header));
+	if (header.eventCount > events.size() / 2)
+		return false;
+
+	setup_ =
+	{
+		.size = size,
+		.mineCount = std::size_t(header.mineCount),
+		.runningBombCount = std::size_t(header.runningBombCount)
+	};
+	seed_ = header.seed;
+	outcome_ =
+	{
+		.state = header.state,
+		.openCount = std::size_t(header.openCount),
+		.flagCount = std::size_t(header.flagCount)
+	};
+	events_.resize(events.size());
+	std::memcpy(events_.data(), events.data(), events.size());
+	eventCount_ = std::size_t(header.eventCount);
+
+	// The duration is only known from the events
+	Event event;
+	Reader reader(*this);
+	lastTimeMs_ = 0;
+	while (reader.next(event))
+		lastTimeMs_ = event.timeMs;
+	return true;
+}
+
+bool Replay::Reader::next(Event& event)
+{
+	std::span<const std::uint8_t> bytes = replay_.events_;
+	std::uint64_t delta, value;
+	std::size_t pos = pos_;
+	if (!Varint::read(bytes, pos, delta) || !Varint::read(bytes, pos, value) || (value & 3) > Chord)
+		return false;
+
+	pos_ = pos;
+	timeMs_ += delta;
+	event =
+	{
+		.action = Action(value & 3),
+		.index = std::size_t(value >> 2),
+		.timeMs = timeMs_
+	};
+	return true;
+}
+
+bool Replay::play(GameLogic& game) const
+{
+	game.resize(setup_.size);
+	game.setMineCount(setup_.mineCount);
+	game.setRunningBombCount(setup_.runningBombCount);
+	game.restart(seed_);
+
+	const Board& board = game.getBoard();
+	if (board.getSize() != setup_.size || board.getMineCount() != setup_.mineCount)
+		return false;
+
+	Event event;
+	Reader reader(*this);
+	std::size_t played = 0;
+	while (reader.next(event))
+	{
+		// A chord must land on an opened cell, an open on a closed one
+		if (!board.isIndexValid(event.index) || (event.action != Flag && board.getCellAt(event.index).opened != (event.action == Chord)))
+			return false;
+
+		bool taken = event.action == Flag ? game.flag(event.index) : game.open(event.index);
+		if (!taken)
+			return false;
+		++played;
+	}
+
+	return played == eventCount_
+	       && game.getState() == outcome_.state
+	       && board.getOpenCount() == outcome_.openCount
+	       && board.getFlagCount() == outcome_.flagCount;
+}
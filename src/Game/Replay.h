@@ -0,0 +1,99 @@
+#pragma once
+#include "Board.h"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+class GameLogic;
+
+/*
+ * Recording of a whole game: the setup and seed it started from, then its
+ * input events as varints, 2 to 5 bytes each. Times are deltas in
+ * milliseconds and cells are indexes, tagged with the action.
+ *
+ * The GameLogic draws every random number from the seed, so playing the
+ * events again on it rebuilds the exact same game, mine moves included. The
+ * outcome recorded at the end tells whether it did.
+ */
+class Replay
+{
+public:
+
+	inline static const std::filesystem::path DEFAULT_DIRECTORY = "replays";
+	inline static const std::filesystem::path EXTENSION = ".mpr";
+
+	enum Action : std::uint8_t
+	{
+		Open,
+		Flag,
+		Chord // an open on an opened cell
+	};
+
+	struct Event
+	{
+		Action action;
+		std::size_t index;
+		std::uint64_t timeMs; // since the first click
+	};
+
+	struct Setup
+	{
+		Vec2s size;
+		std::size_t mineCount;
+		std::size_t runningBombCount; // as clamped at the first click
+	};
+
+	struct Outcome
+	{
+		std::uint8_t state; // GameLogic::State
+		std::size_t openCount;
+		std::size_t flagCount;
+	};
+
+	// Drops the events of the previous game.
+	void begin(std::uint64_t seed);
+	void record(Action action, std::size_t index, std::uint64_t timeMs);
+	// The setup is only final at the end: the running bombs are picked at the first click.
+	void finish(const Setup& setup, const Outcome& outcome);
+
+	std::uint64_t getSeed() const { return seed_; }
+	const Setup& getSetup() const { return setup_; }
+	const Outcome& getOutcome() const { return outcome_; }
+	std::size_t getEventCount() const { return eventCount_; }
+	std::span<const std::uint8_t> getEventBytes() const { return events_; }
+	std::uint64_t getDuration() const { return lastTimeMs_; } // ms
+
+	bool save(const std::filesystem::path& file) const;
+	// Leaves the replay untouched on failure.
+	bool load(const std::filesystem::path& file);
+
+	// Decodes the events in order.
+	class Reader
+	{
+	public:
+
+		explicit Reader(const Replay& replay) : replay_(replay), pos_(0), timeMs_(0) {}
+		// Returns false past the last event, or on a torn one.
+		bool next(Event& event);
+
+	private:
+
+		const Replay& replay_;
+		std::size_t pos_;
+		std::uint64_t timeMs_;
+	};
+
+	// Restarts 'game' from the setup and runs every event on it, as fast as
+	// it can. Returns true if the game ends the way the recording did.
+	bool play(GameLogic& game) const;
+
+private:
+
+	std::uint64_t seed_ = 0;
+	Setup setup_{};
+	Outcome outcome_{};
+	std::vector<std::uint8_t> events_;
+	std::size_t eventCount_ = 0;
+	std::uint64_t lastTimeMs_ = 0;
+};
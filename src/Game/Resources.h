@@ -1,4 +1,6 @@
 #pragma once
+#include "Tile.h"
+#include "Sim/DifficultyTable.h"
 #include <SFML/Audio/SoundBuffer.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/Texture.hpp>
@@ -33,20 +35,7 @@ inline const sf::Texture cellsAtlas{RESOURCES_DIR / CELLS_ATLAS_FILE};
 
 constexpr sf::Vector2f cellSize = {64, 64};
 
-/*
- * Skin of a cell, as its row-major index inside the atlas. This is the only
- * thing the renderer stores per cell, so the order below must match the atlas
- * image: the shader turns the index back into a pixel offset by dividing by
- * the number of columns. Keep the list within 16 entries, otherwise it no
- * longer fits in the nibble the state texture reserves for it.
- */
-enum class Tile : std::uint8_t
-{
-	Opened0, Opened1, Opened2, Opened3,
-	Opened4, Opened5, Opened6, Opened7,
-	Opened8, Unopened, UnopenedSelected, UnopenedFlagged,
-	OpenedRunningMine, OpenedMine, OpenedClickedMine, OpenedNoMine,
-};
+// Tile, the skin of a cell, is in Tile.h: the headless core encodes boards too.
 
 } // namespace Textures
 
@@ -65,6 +54,24 @@ inline const std::filesystem::path victory{RESOURCES_DIR / VICTORY_FILE};
 
 } // namespace Sounds
 
+namespace Data
+{
+
+constexpr auto DIFFICULTY_FILE = "difficulty.bin";
+
+// Rebuilt by the MineTable tool
+inline const DifficultyTable difficulty{RESOURCES_DIR / DIFFICULTY_FILE};
+
+} // namespace Data
+
+namespace Limits
+{
+
+// Queried once for all: the custom game menu checks every keystroke against it.
+inline const unsigned maxTextureSize = sf::Texture::getMaximumSize();
+
+} // namespace Limits
+
 namespace Shaders
 {
 
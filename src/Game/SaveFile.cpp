@@ -0,0 +1,271 @@
+#include "SaveFile.h"
+#include "Utils/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+
+constexpr std::uint32_t MAGIC = 0x5653504D; // "MPSV"
+constexpr std::uint32_t VERSION = 3; // 2: journal sequence, 3: game id
+constexpr std::size_t LAYER_COUNT = 3;
+
+enum Encoding : std::uint8_t
+{
+	Raw,
+	RunLength
+};
+
+struct Header
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t width, height;
+	std::uint64_t playingTimeUs;
+	std::uint64_t runningBombCount;
+	std::uint64_t runningBombIndexCount;
+	std::uint64_t sequence;
+	std::uint64_t gameId;
+	std::uint64_t layerWords[LAYER_COUNT]; // stored size of each layer
+	float rotationSpeed;
+	std::uint8_t state;
+	std::uint8_t encodings[LAYER_COUNT];
+};
+
+// Keeps the sections after it aligned on their words
+static_assert(sizeof(Header) % sizeof(std::uint64_t) == 0);
+
+constexpr std::uint64_t RUN_BIT = std::uint64_t(1) << 63;
+constexpr std::size_t MIN_RUN = 3; // a run costs two words
+
+std::size_t runLength(std::span<const std::uint64_t> words, std::size_t i, std::size_t limit)
+{
+	std::size_t run = 1;
+	while (run < limit && i + run < words.size() && words[i + run] == words[i])
+		++run;
+	return run;
+}
+
+void encodeRuns(std::span<const std::uint64_t> words, std::vector<std::uint64_t>& out)
+{
+	for (std::size_t i = 0; i < words.size();)
+	{
+		std::size_t run = runLength(words, i, words.size());
+		if (run >= MIN_RUN)
+		{
+			out.push_back(RUN_BIT | run);
+			out.push_back(words[i]);
+			i += run;
+			continue;
+		}
+
+		// Literals go on until the next run worth encoding
+		std::size_t first = i;
+		while (i < words.size() && (run = runLength(words, i, MIN_RUN)) < MIN_RUN)
+			i += run;
+
+		out.push_back(i - first);
+		out.insert(out.end(), words.begin() + std::ptrdiff_t(first), words.begin() + std::ptrdiff_t(i));
+	}
+}
+
+bool decodeRuns(std::span<const std::uint64_t> in, std::span<std::uint64_t> out)
+{
+	std::size_t o = 0;
+	for (std::size_t i = 0; i < in.size();)
+	{
+		std::uint64_t control = in[i++];
+		std::size_t count = std::size_t(control & ~RUN_BIT);
+		if (count > out.size() - o)
+			return false;
+
+		if (control & RUN_BIT)
+		{
+			if (i == in.size())
+				return false;
+			std::fill_n(out.begin() + std::ptrdiff_t(o), count, in[i++]);
+		}
+		else
+		{
+			if (count > in.size() - i)
+				return false;
+			std::copy_n(in.begin() + std::ptrdiff_t(i), count, out.begin() + std::ptrdiff_t(o));
+			i += count;
+		}
+		o += count;
+	}
+	return o == out.size();
+}
+
+template <class T>
+void writeSpan(std::ofstream& out, std::span<const T> data)
+{
+	out.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size_bytes()));
+}
+
+// Board or Board::Snapshot, the same layers either way.
+template <class View>
+bool saveView(const std::filesystem::path& file, const View& board, const SaveFile::Meta& meta, bool compress)
+{
+	Vec2s size = board.getSize();
+	if (!Board::isSizeValid(size))
+		return false;
+
+	Header header{};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.width = size.x;
+	header.height = size.y;
+	header.playingTimeUs = meta.playingTimeUs;
+	header.runningBombCount = meta.runningBombCount;
+	header.runningBombIndexCount = meta.runningBombIndexes.size();
+	header.sequence = meta.sequence;
+	header.gameId = meta.gameId;
+	header.rotationSpeed = meta.rotationSpeed;
+	header.state = meta.state;
+
+	// Layers are packed up front: the header needs their stored sizes
+	std::size_t wordCount = Board::getLayerWordCount(size);
+	std::vector<std::uint64_t> layer(wordCount), sections;
+	sections.reserve(wordCount * LAYER_COUNT);
+
+	constexpr Board::Layer layers[LAYER_COUNT] = {Board::Layer::Mined, Board::Layer::Opened, Board::Layer::Flagged};
+	for (std::size_t l = 0; l < LAYER_COUNT; ++l)
+	{
+		board.exportLayer(layers[l], layer);
+
+		std::size_t first = sections.size();
+		if (compress)
+		{
+			encodeRuns(layer, sections);
+			if (sections.size() - first < wordCount)
+			{
+				header.encodings[l] = RunLength;
+				header.layerWords[l] = sections.size() - first;
+				continue;
+			}
+			sections.resize(first);
+		}
+
+		sections.insert(sections.end(), layer.begin(), layer.end());
+		header.encodings[l] = Raw;
+		header.layerWords[l] = wordCount;
+	}
+
+	// Written aside then swapped in, a crash mid-save keeps the previous save
+	std::filesystem::path temp = file;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		writeSpan(out, std::span<const Header>(&header, 1));
+		std::vector<std::uint64_t> indexes(meta.runningBombIndexes.begin(), meta.runningBombIndexes.end());
+		writeSpan<std::uint64_t>(out, indexes);
+		writeSpan<std::uint64_t>(out, sections);
+		// Flushing can fail too: only a file closed whole replaces the save
+		out.close();
+		if (out.fail())
+		{
+			std::error_code error;
+			std::filesystem::remove(temp, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, file, error);
+	return !error;
+}
+
+} // namespace
+
+bool SaveFile::save(const std::filesystem::path& file, const Board& board, const Meta& meta, bool compress)
+{
+	return saveView(file, board, meta, compress);
+}
+
+bool SaveFile::save(const std::filesystem::path& file, const Board::Snapshot& board, const Meta& meta, bool compress)
+{
+	return saveView(file, board, meta, compress);
+}
+
+bool SaveFile::load(const std::filesystem::path& file, Board& board, Meta& meta)
+{
+	MappedFile mapped(file);
+	auto bytes = mapped.bytes();
+	if (bytes.size() < sizeof(Header) || bytes.size() % sizeof(std::uint64_t))
+		return false;
+
+	Header header;
+	std::memcpy(&header, bytes.data(), sizeof(Header));
+	if (header.magic != MAGIC || header.version != VERSION)
+		return false;
+
+	Vec2s size = {std::size_t(header.width), std::size_t(header.height)};
+	if (!Board::isSizeValid(size))
+		return false;
+
+	// The mapping is page aligned and the header a whole number of words
+	std::span<const std::uint64_t> words(
+		reinterpret_cast<const std::uint64_t*>(bytes.data() + sizeof(Header)),
+		(bytes.size() - sizeof(Header)) / sizeof(std::uint64_t));
+
+	std::size_t cellCount = size.x * size.y;
+	if (header.runningBombIndexCount > words.size() || header.runningBombIndexCount > cellCount)
+		return false;
+
+	auto indexes = words.first(std::size_t(header.runningBombIndexCount));
+	words = words.subspan(indexes.size());
+
+	std::size_t wordCount = Board::getLayerWordCount(size);
+	std::span<const std::uint64_t> layers[LAYER_COUNT];
+	std::vector<std::uint64_t> decoded[LAYER_COUNT];
+	for (std::size_t l = 0; l < LAYER_COUNT; ++l)
+	{
+		if (header.layerWords[l] > words.size())
+			return false;
+
+		auto stored = words.first(std::size_t(header.layerWords[l]));
+		words = words.subspan(stored.size());
+
+		switch (header.encodings[l])
+		{
+		case Raw:
+			// Used in place, straight from the mapping
+			layers[l] = stored;
+			break;
+		case RunLength:
+			decoded[l].resize(wordCount);
+			if (!decodeRuns(stored, decoded[l]))
+				return false;
+			layers[l] = decoded[l];
+			break;
+		default:
+			return false;
+		}
+	}
+
+	if (!words.empty())
+		return false;
+
+	Board loaded;
+	if (!loaded.importLayers(size, layers[0], layers[1], layers[2]))
+		return false;
+
+	for (std::uint64_t index : indexes)
+	{
+		if (index >= cellCount || !loaded.getCellAt(std::size_t(index)).mined)
+			return false;
+	}
+
+	board = std::move(loaded);
+	meta.state = header.state;
+	meta.playingTimeUs = header.playingTimeUs;
+	meta.rotationSpeed = header.rotationSpeed;
+	meta.runningBombCount = header.runningBombCount;
+	meta.runningBombIndexes.assign(indexes.begin(), indexes.end());
+	meta.sequence = header.sequence;
+	meta.gameId = header.gameId;
+	return true;
+}
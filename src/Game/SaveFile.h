@@ -0,0 +1,43 @@
+#pragma once
+#include "Board.h"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/*
+ * Versioned binary save of a game.
+ *
+ * The board is stored as its three bit-packed layers (mined, opened, flagged),
+ * an eighth of a byte per cell each, after a fixed header holding the game
+ * metadata. Every section is a whole number of 64 bits words, so a load maps
+ * the file and hands uncompressed layers to the Board as they are.
+ *
+ * A layer can be run-length compressed, word wise: a control word whose top
+ * bit tells a run of 'count' copies of the next word from 'count' literal
+ * words. Opened and flagged layers shrink to almost nothing on most boards,
+ * the mined layer is compressed only when it pays off.
+ */
+namespace SaveFile
+{
+
+inline const std::filesystem::path DEFAULT_PATH = "save.mpp";
+
+// Everything but the board that is needed to resume a game.
+struct Meta
+{
+	std::uint8_t state;           // Minesweeper state
+	std::uint64_t playingTimeUs;
+	float rotationSpeed;
+	std::uint64_t runningBombCount;
+	std::vector<std::size_t> runningBombIndexes;
+	std::uint64_t sequence; // autosave journal records already applied to the board
+	std::uint64_t gameId;   // autosave game the board belongs to, its journal names it too
+};
+
+bool save(const std::filesystem::path& file, const Board& board, const Meta& meta, bool compress = true);
+bool save(const std::filesystem::path& file, const Board::Snapshot& board, const Meta& meta, bool compress = true);
+
+// Leaves 'board' and 'meta' untouched on failure.
+bool load(const std::filesystem::path& file, Board& board, Meta& meta);
+
+} // namespace SaveFile
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+namespace Resources::Textures
+{
+
+/*
+ * Skin of a cell, as its row-major index inside the atlas. This is the only
+ * thing the renderer stores per cell, so the order below must match the atlas
+ * image: the shader turns the index back into a pixel offset by dividing by
+ * the number of columns. Keep the list within 16 entries, otherwise it no
+ * longer fits in the nibble the state texture reserves for it.
+ */
+enum class Tile : std::uint8_t
+{
+	Opened0, Opened1, Opened2, Opened3,
+	Opened4, Opened5, Opened6, Opened7,
+	Opened8, Unopened, UnopenedSelected, UnopenedFlagged,
+	OpenedRunningMine, OpenedMine, OpenedClickedMine, OpenedNoMine,
+};
+
+} // namespace Resources::Textures
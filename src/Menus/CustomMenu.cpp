@@ -1,9 +1,9 @@
 #include "CustomMenu.h"
 #include "Core/App.h"
 #include "Game/Minesweeper.h"
+#include "Game/Resources.h"
 #include "UI/UITarget.h"
-#include <algorithm>
-#include <cmath>
+#include "Utils/SystemMemory.h"
 #include <cstdint>
 #include <format>
 #include <iterator>
@@ -14,54 +14,37 @@ namespace
 constexpr sf::Vector2i BUTTON_SIZE = {150, 28};
 constexpr sf::Vector2i ELEMENTS_GAP = {200, 60};
 
-// Difficulty derived from mine density, corrected for board size and shape.
-//  - density : more mines per cell is harder (main factor)
-//  - size    : a bigger board forces more decisions, slightly harder
-//  - shape   : a square is the easiest shape, narrower is harder.
-double difficultyScore(std::size_t width, std::size_t height, std::size_t mines)
+// Labels the chances of the headless player to win, as measured by simulation.
+std::string_view difficultyLabel(double winRate)
 {
-	double cells = double(width) * double(height);
-	if (cells <= 0.0)
-		return 0.0;
-
-	double density = double(mines) / cells;
-	double sizeFactor = std::clamp(std::pow(cells / 256.0, 0.15), 0.8, 1.5);
-	double minDim = double(std::min(width, height));
-	double shapeFactor = 1.0 + 0.7 / minDim;
-
-	return std::clamp(density * sizeFactor * shapeFactor, 0.0, 1.0);
-}
-
-std::string_view difficultyLabel(double score)
-{
-	if (score < 0.04) return "Free Win";
-	if (score < 0.14) return "Easy";
-	if (score < 0.18) return "Medium";
-	if (score < 0.25) return "Hard";
+	if (winRate >= 0.90) return "Free Win";
+	if (winRate >= 0.60) return "Easy";
+	if (winRate >= 0.30) return "Medium";
+	if (winRate >= 0.01) return "Hard";
 	return "Impossible";
 }
 
-sf::Color difficultyColor(double score)
+sf::Color difficultyColor(double winRate)
 {
 	struct Stop { double at; sf::Color color; };
 	static constexpr Stop stops[] =
 	{
-		{0.020, {0x3B, 0x82, 0xF6}}, // Free Win   - blue
-		{0.090, {0x22, 0xC5, 0x5E}}, // Easy       - green
-		{0.160, {0xEA, 0xB3, 0x08}}, // Medium     - yellow
-		{0.215, {0xEF, 0x44, 0x44}}, // Hard       - red
-		{0.280, {0xA8, 0x55, 0xF7}}, // Impossible - purple
+		{0.005, {0xA8, 0x55, 0xF7}}, // Impossible - purple
+		{0.100, {0xEF, 0x44, 0x44}}, // Hard       - red
+		{0.450, {0xEA, 0xB3, 0x08}}, // Medium     - yellow
+		{0.750, {0x22, 0xC5, 0x5E}}, // Easy       - green
+		{0.950, {0x3B, 0x82, 0xF6}}, // Free Win   - blue
 	};
 
 	constexpr std::size_t n = std::size(stops);
-	if (score <= stops[0].at) return stops[0].color;
-	if (score >= stops[n - 1].at) return stops[n - 1].color;
+	if (winRate <= stops[0].at) return stops[0].color;
+	if (winRate >= stops[n - 1].at) return stops[n - 1].color;
 
 	for (std::size_t i = 1; i < n; ++i)
 	{
-		if (score <= stops[i].at)
+		if (winRate <= stops[i].at)
 		{
-			double t = (score - stops[i - 1].at) / (stops[i].at - stops[i - 1].at);
+			double t = (winRate - stops[i - 1].at) / (stops[i].at - stops[i - 1].at);
 			const sf::Color& c0 = stops[i - 1].color;
 			const sf::Color& c1 = stops[i].color;
 			auto lerp = [t](std::uint8_t a, std::uint8_t b)
@@ -72,6 +55,17 @@ sf::Color difficultyColor(double score)
 	return stops[n - 1].color;
 }
 
+// In binary units, like memory is sold.
+void formatBytes(std::back_insert_iterator<std::string> out, std::uint64_t bytes)
+{
+	constexpr std::string_view units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+	double value = double(bytes);
+	std::size_t unit = 0;
+	for (; value >= 1024.0 && unit + 1 < std::size(units); ++unit)
+		value /= 1024.0;
+	std::format_to(out, "{:.1f} {}", value, units[unit]);
+}
+
 }
 
 CustomMenu::CustomMenu(Minesweeper& game)
@@ -85,6 +79,7 @@ CustomMenu::CustomMenu(Minesweeper& game)
 	, minesField_{.rect = {{}, BUTTON_SIZE}, .value = 50}
 	, backBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Back"}
 	, startBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Start"}
+	, startable_(false)
 {
 	updateDiagnostic();
 }
@@ -135,6 +130,10 @@ UIEvent::Result CustomMenu::operator()(const UIEvent::Released& event)
 	}
 	else if (tracker_.isClicked(startBtn_, event.position))
 	{
+		// The diagnostic tells why
+		if (!startable_)
+			return UIEvent::Consumed;
+
 		Vec2s newSize = {widthField_.value, heightField_.value};
 		game_.resize(newSize);
 		game_.setMineCount(minesField_.value);
@@ -189,11 +188,41 @@ void CustomMenu::updateDiagnostic()
 		std::format_to(out, "Max number of mines exceeded: {}/{}\n", mineCount, cellCount - 1);
 	}
 
+	// Boards too big for this machine would fail to allocate halfway through,
+	// or leave the renderer without its texture
+	Minesweeper::Footprint footprint = Minesweeper::getFootprint(newSize);
 	if (diagnosticStr_.empty())
 	{
-		double score = difficultyScore(newSize.x, newSize.y, mineCount);
-		std::format_to(out, "Difficulty: {}", difficultyLabel(score));
-		diagnosticText_.color = difficultyColor(score);
+		if (footprint.textureRows > Resources::Limits::maxTextureSize)
+		{
+			std::format_to(out, "Too big for the graphics card: {} texture rows, {} max\n",
+			               footprint.textureRows, Resources::Limits::maxTextureSize);
+		}
+
+		std::optional<std::uint64_t> available = getAvailableMemory();
+		if (available && footprint.hostBytes > *available)
+		{
+			std::format_to(out, "Not enough memory: ");
+			formatBytes(out, footprint.hostBytes);
+			std::format_to(out, " needed, ");
+			formatBytes(out, *available);
+			std::format_to(out, " available\n");
+		}
+	}
+
+	startable_ = diagnosticStr_.empty();
+	if (startable_)
+	{
+		// A few interpolations in a memory-mapped table, cheap enough for every keystroke
+		double winRate = Resources::Data::difficulty.winRate(newSize.x, newSize.y, mineCount);
+		std::format_to(out, "Difficulty: {} ({:.1f}% win rate)\n", difficultyLabel(winRate), winRate * 100.0);
+
+		std::format_to(out, "Memory: ");
+		formatBytes(out, footprint.hostBytes);
+		std::format_to(out, " + ");
+		formatBytes(out, footprint.gpuBytes);
+		std::format_to(out, " of video memory");
+		diagnosticText_.color = difficultyColor(winRate);
 	}
 	else
 	{
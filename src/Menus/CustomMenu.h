@@ -31,5 +31,6 @@ private:
 	Button backBtn_, startBtn_;
 	Cursor cursor_;
 	ClickTracker tracker_;
+	bool startable_; // the diagnostic found nothing wrong
 };
 
@@ -3,6 +3,7 @@
 #include "MainMenu.h"
 #include "CustomMenu.h"
 #include "Game/GameUI.h"
+#include "Game/SaveFile.h"
 #include "UI/UITarget.h"
 
 namespace
@@ -11,6 +12,10 @@ namespace
 constexpr sf::Vector2i BUTTON_SIZE = {150, 28};
 constexpr sf::Vector2i ELEMENTS_GAP = {200, 60};
 
+constexpr std::string_view CONTINUE_TEXT = "Continue";
+constexpr std::string_view NO_SAVE_TEXT = "No save";
+constexpr std::string_view LOAD_FAILED_TEXT = "Load failed!";
+
 constexpr std::string_view GAME_MODE_TITLE[PlayMenu::GameMode::Count] =
 {
 	"Default",
@@ -44,6 +49,7 @@ PlayMenu::PlayMenu(Minesweeper& game)
 	, intermediateBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Intermediate"}
 	, expertBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Expert"}
 	, backBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Back"}
+	, continueBtn_{.rect = {{}, BUTTON_SIZE}, .text = CONTINUE_TEXT}
 	, customBtn_{.rect = {{}, BUTTON_SIZE}, .text = "Custom"} {}
 
 UIEvent::Result PlayMenu::operator()(const UIEvent::Resized& event)
@@ -57,6 +63,7 @@ UIEvent::Result PlayMenu::operator()(const UIEvent::Resized& event)
 	intermediateBtn_.rect.position = centerView - intermediateBtn_.rect.size / 2;
 	expertBtn_.rect.position = centerView - expertBtn_.rect.size / 2 + sf::Vector2i(ELEMENTS_GAP.x, 0);
 	backBtn_.rect.position = centerView - backBtn_.rect.size / 2 + sf::Vector2i(-ELEMENTS_GAP.x, ELEMENTS_GAP.y);
+	continueBtn_.rect.position = centerView - continueBtn_.rect.size / 2 + sf::Vector2i(0, ELEMENTS_GAP.y);
 	customBtn_.rect.position = centerView - customBtn_.rect.size / 2 + ELEMENTS_GAP;
 	gameModeDescription_.position = centerView + sf::Vector2i(0, ELEMENTS_GAP.y * 2);
 	return UIEvent::Consumed;
@@ -72,6 +79,7 @@ UIEvent::Result PlayMenu::operator()(const UIEvent::Pressed& event)
 			       intermediateBtn_,
 			       expertBtn_,
 			       backBtn_,
+			       continueBtn_,
 			       customBtn_
 		       })
 	       ? UIEvent::Consumed
@@ -102,6 +110,21 @@ UIEvent::Result PlayMenu::operator()(const UIEvent::Released& event)
 	{
 		event.app.submitCommand<SwapUI>(SwapUI::DEFAULT<MainMenu>);
 	}
+	else if (tracker_.isClicked(continueBtn_, event.position))
+	{
+		// No reset of the parameters: a load sets them all from the save, and a
+		// failed one keeps those of the current game
+		if (event.app.getGame().load(SaveFile::DEFAULT_PATH))
+		{
+			event.app.submitCommand<SwapUI>([&app = event.app](AppUI& ui) { ui.emplace<GameUI>(app); });
+			event.app.submitCommand<ChangeClearColor>(sf::Color{0x79, 0x31, 0x32, 0x00});
+		}
+		else
+		{
+			std::error_code error;
+			continueBtn_.text = std::filesystem::exists(SaveFile::DEFAULT_PATH, error) ? LOAD_FAILED_TEXT : NO_SAVE_TEXT;
+		}
+	}
 	else if (tracker_.isClicked(customBtn_, event.position))
 	{
 		event.app.submitCommand<SwapUI>([&game = event.app.getGame()](AppUI& ui) { ui.emplace<CustomMenu>(game); });
@@ -120,6 +143,7 @@ void PlayMenu::render(UITarget& target) const
 	target.draw(intermediateBtn_);
 	target.draw(expertBtn_);
 	target.draw(backBtn_);
+	target.draw(continueBtn_);
 	target.draw(customBtn_);
 }
 
@@ -31,6 +31,6 @@ private:
 
 	GameMode gameMode_;
 	Text gameModeText_, gameModeDescription_;
-	Button gameModeBtn_, beginnerBtn_, intermediateBtn_, expertBtn_, backBtn_, customBtn_;
+	Button gameModeBtn_, beginnerBtn_, intermediateBtn_, expertBtn_, backBtn_, continueBtn_, customBtn_;
 	ClickTracker tracker_;
 };
@@ -1,6 +1,36 @@
 ﻿#include "Core/App.h"
+#include "Utils/Trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
 
-int main()
+int main(int argc, char** argv)
 {
-	return App().run();
+	// --trace <file>: records the session as a Chrome trace
+	// --audit-allocations: plays a scripted session, fails if steady frames allocate
+	bool auditAllocations = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view arg = argv[i];
+		if (arg == "--trace")
+		{
+			// The path is taken whatever it looks like, never parsed as an option
+			if (++i == argc)
+			{
+				std::fprintf(stderr, "Usage: %s [--trace <file>] [--audit-allocations]\n", argv[0]);
+				return EXIT_FAILURE;
+			}
+			if (!Trace::start(argv[i]))
+				std::fprintf(stderr, "Cannot write a trace to %s\n", argv[i]);
+		}
+		else if (arg == "--audit-allocations")
+			auditAllocations = true;
+	}
+
+	App app;
+	if (auditAllocations)
+		app.auditAllocations();
+	int result = app.run();
+	Trace::stop();
+	return result;
 }
@@ -0,0 +1,344 @@
+#include "BoardCorpus.h"
+#include "Utils/MappedFile.h"
+#include "Utils/MyRandom.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+
+using BoardCorpus::Layout;
+
+constexpr std::uint32_t MAGIC = 0x4342504D; // "MPBC"
+constexpr std::uint32_t VERSION = 1;
+
+struct Header
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t entryCount;
+};
+
+struct EntryHeader
+{
+	std::uint64_t width, height;
+	std::uint64_t start;
+	std::uint32_t layout;
+	std::uint32_t padding;
+};
+
+static_assert(sizeof(Header) % sizeof(std::uint64_t) == 0);
+static_assert(sizeof(EntryHeader) % sizeof(std::uint64_t) == 0);
+
+constexpr std::string_view LAYOUT_NAMES[std::size_t(Layout::Count)] =
+{
+	"empty",
+	"random",
+	"spiral",
+	"serpentine",
+	"comb",
+	"lattice",
+	"diagonal",
+};
+
+constexpr double RANDOM_DENSITY = 0.16;
+
+// Corridors are 3 cells wide, so that their middle cells have no mine around,
+// and 4 cells apart: one cell of wall between two of them.
+constexpr std::size_t CORRIDOR_SPACING = 4;
+constexpr std::size_t LATTICE_SPACING = 4;
+// The 3x3 neighbourhood of a cell spans 5 diagonals, the lines must be further apart
+constexpr std::size_t DIAGONAL_SPACING = 6;
+
+constexpr std::size_t MIN_SIDE = 8;
+
+// One byte per cell while laying out, packed at the end
+class Grid
+{
+public:
+
+	Grid(const Vec2s& size, bool mined)
+		: size_(size)
+		, cells_(size.x * size.y, mined)
+		, cursor_{1, 1}
+	{}
+
+	void mine(std::size_t x, std::size_t y) { cells_[y * size_.x + x] = true; }
+
+	// Clears the 3x3 block centered on each cell from the cursor to (x, y),
+	// along a row or a column.
+	void carveTo(std::size_t x, std::size_t y)
+	{
+		while (true)
+		{
+			carve(cursor_.x, cursor_.y);
+			if (cursor_ == Vec2s{x, y})
+				break;
+
+			if (cursor_.x != x)
+				cursor_.x += cursor_.x < x ? 1 : std::size_t(-1);
+			else
+				cursor_.y += cursor_.y < y ? 1 : std::size_t(-1);
+		}
+	}
+
+	void moveTo(std::size_t x, std::size_t y) { cursor_ = {x, y}; }
+
+	// No mine in the 3x3 block around the cell.
+	bool isEmptyAround(std::size_t index) const
+	{
+		std::size_t x = index % size_.x, y = index / size_.x;
+		for (std::size_t ny = y ? y - 1 : 0; ny <= std::min(y + 1, size_.y - 1); ++ny)
+			for (std::size_t nx = x ? x - 1 : 0; nx <= std::min(x + 1, size_.x - 1); ++nx)
+				if (cells_[ny * size_.x + nx])
+					return false;
+		return true;
+	}
+
+	void pack(std::vector<std::uint64_t>& words) const
+	{
+		words.assign(Board::getLayerWordCount(size_), 0);
+		for (std::size_t i = 0; i < cells_.size(); ++i)
+			words[i / 64] |= std::uint64_t(cells_[i]) << (i % 64);
+	}
+
+private:
+
+	void carve(std::size_t x, std::size_t y)
+	{
+		for (std::size_t ny = y - 1; ny <= y + 1; ++ny)
+			for (std::size_t nx = x - 1; nx <= x + 1; ++nx)
+				if (nx < size_.x && ny < size_.y)
+					cells_[ny * size_.x + nx] = false;
+	}
+
+	Vec2s size_;
+	std::vector<std::uint8_t> cells_;
+	Vec2s cursor_;
+};
+
+void layOut(Layout layout, Grid& grid, const Vec2s& size)
+{
+	std::size_t right = size.x - 2, bottom = size.y - 2;
+	switch (layout)
+	{
+	case Layout::Spiral:
+	{
+		// Laps go clockwise, each one a corridor inside the previous one
+		std::size_t x0 = 1, y0 = 1, x1 = right, y1 = bottom;
+		while (x0 <= x1 && y0 <= y1)
+		{
+			grid.carveTo(x1, y0);
+			grid.carveTo(x1, y1);
+			grid.carveTo(x0, y1);
+			if (y0 + CORRIDOR_SPACING > y1 || x0 + CORRIDOR_SPACING > x1)
+				break;
+			grid.carveTo(x0, y0 + CORRIDOR_SPACING);
+
+			x0 += CORRIDOR_SPACING;
+			y0 += CORRIDOR_SPACING;
+			x1 -= CORRIDOR_SPACING;
+			y1 -= CORRIDOR_SPACING;
+		}
+	}
+	break;
+
+	case Layout::Serpentine:
+		for (std::size_t y = 1; y <= bottom; y += CORRIDOR_SPACING)
+		{
+			bool rightward = (y / CORRIDOR_SPACING) % 2 == 0;
+			grid.carveTo(rightward ? right : 1, y);
+			if (y + CORRIDOR_SPACING <= bottom)
+				grid.carveTo(rightward ? right : 1, y + CORRIDOR_SPACING);
+		}
+		break;
+
+	case Layout::Comb:
+		grid.carveTo(right, 1);
+		for (std::size_t x = 1; x <= right; x += CORRIDOR_SPACING)
+		{
+			grid.moveTo(x, 1);
+			grid.carveTo(x, bottom);
+		}
+		break;
+
+	case Layout::Lattice:
+		for (std::size_t y = 0; y < size.y; y += LATTICE_SPACING)
+			for (std::size_t x = 0; x < size.x; x += LATTICE_SPACING)
+				grid.mine(x, y);
+		break;
+
+	case Layout::Diagonal:
+		for (std::size_t y = 0; y < size.y; ++y)
+			for (std::size_t x = (DIAGONAL_SPACING - y % DIAGONAL_SPACING) % DIAGONAL_SPACING; x < size.x; x += DIAGONAL_SPACING)
+				grid.mine(x, y);
+		break;
+
+	default:
+		break;
+	}
+}
+
+} // namespace
+
+std::string_view BoardCorpus::getName(Layout layout)
+{
+	return layout < Layout::Count ? LAYOUT_NAMES[std::size_t(layout)] : "unknown";
+}
+
+bool BoardCorpus::generate(Layout layout, const Vec2s& size, Entry& entry)
+{
+	if (!Board::isSizeValid(size) || size.x < MIN_SIDE || size.y < MIN_SIDE || layout >= Layout::Count)
+		return false;
+
+	std::size_t cellCount = size.x * size.y;
+	entry.layout = layout;
+	entry.size = size;
+
+	if (layout == Layout::Random)
+	{
+		Board board;
+		board.resize(size);
+		board.setMineCount(std::size_t(double(cellCount) * RANDOM_DENSITY));
+		board.placeMines();
+		entry.mined.resize(Board::getLayerWordCount(size));
+		board.exportLayer(Board::Layer::Mined, entry.mined);
+
+		// Anywhere on the board, not always near the top
+		std::size_t first = randomBelow(cellCount);
+		for (std::size_t i = 0; i < cellCount; ++i)
+		{
+			std::size_t index = (first + i) % cellCount;
+			const Cell& cell = board.getCellAt(index);
+			if (!cell.mined && !cell.adjacentMines)
+			{
+				entry.start = index;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Corridors are carved out of a full board, patterns are drawn on an empty one
+	bool carved = layout == Layout::Spiral || layout == Layout::Serpentine || layout == Layout::Comb;
+	Grid grid(size, carved);
+	layOut(layout, grid, size);
+
+	switch (layout)
+	{
+	case Layout::Empty:
+		entry.start = size.y / 2 * size.x + size.x / 2;
+		break;
+	case Layout::Lattice:
+		entry.start = 2 * size.x + 2;
+		break;
+	case Layout::Diagonal:
+		// On the top row, at the head of the longest diagonal
+		entry.start = (size.x - 1 - DIAGONAL_SPACING / 2) / DIAGONAL_SPACING * DIAGONAL_SPACING + DIAGONAL_SPACING / 2;
+		break;
+	default:
+		entry.start = size.x + 1; // where the corridor begins
+		break;
+	}
+
+	if (!grid.isEmptyAround(entry.start))
+		return false;
+
+	grid.pack(entry.mined);
+	return true;
+}
+
+bool BoardCorpus::makeBoard(const Entry& entry, Board& board)
+{
+	std::vector<std::uint64_t> none(entry.mined.size(), 0);
+	return board.importLayers(entry.size, entry.mined, none, none);
+}
+
+bool BoardCorpus::save(const std::filesystem::path& file, std::span<const Entry> entries)
+{
+	Header header{.magic = MAGIC, .version = VERSION, .entryCount = entries.size()};
+
+	// Written aside then swapped in, like saves
+	std::filesystem::path temp = file;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const Entry& entry : entries)
+		{
+			EntryHeader entryHeader
+			{
+				.width = entry.size.x,
+				.height = entry.size.y,
+				.start = entry.start,
+				.layout = std::uint32_t(entry.layout),
+				.padding = 0
+			};
+			out.write(reinterpret_cast<const char*>(&entryHeader), sizeof(entryHeader));
+			out.write(reinterpret_cast<const char*>(entry.mined.data()), std::streamsize(entry.mined.size() * sizeof(std::uint64_t)));
+		}
+		// Checked once closed, the last buffer flushed
+		out.close();
+		if (out.fail())
+		{
+			std::error_code error;
+			std::filesystem::remove(temp, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, file, error);
+	return !error;
+}
+
+bool BoardCorpus::load(const std::filesystem::path& file, std::vector<Entry>& entries)
+{
+	MappedFile mapped(file);
+	auto bytes = mapped.bytes();
+	if (bytes.size() < sizeof(Header))
+		return false;
+
+	Header header;
+	std::memcpy(&header, bytes.data(), sizeof(Header));
+	if (header.magic != MAGIC || header.version != VERSION)
+		return false;
+
+	// Every entry takes its header at least
+	bytes = bytes.subspan(sizeof(Header));
+	if (header.entryCount > bytes.size() / sizeof(EntryHeader))
+		return false;
+
+	std::vector<Entry> loaded(std::size_t(header.entryCount));
+	for (Entry& entry : loaded)
+	{
+		EntryHeader entryHeader;
+		if (bytes.size() < sizeof(EntryHeader))
+			return false;
+		std::memcpy(&entryHeader, bytes.data(), sizeof(EntryHeader));
+		bytes = bytes.subspan(sizeof(EntryHeader));
+
+		Vec2s size = {std::size_t(entryHeader.width), std::size_t(entryHeader.height)};
+		if (!Board::isSizeValid(size) || entryHeader.start >= size.x * size.y || entryHeader.layout >= std::uint32_t(Layout::Count))
+			return false;
+
+		std::size_t wordCount = Board::getLayerWordCount(size);
+		if (wordCount > bytes.size() / sizeof(std::uint64_t))
+			return false;
+
+		entry.layout = Layout(entryHeader.layout);
+		entry.size = size;
+		entry.start = std::size_t(entryHeader.start);
+		entry.mined.resize(wordCount);
+		std::memcpy(entry.mined.data(), bytes.data(), wordCount * sizeof(std::uint64_t));
+		bytes = bytes.subspan(wordCount * sizeof(std::uint64_t));
+	}
+
+	if (!bytes.empty())
+		return false;
+
+	entries = std::move(loaded);
+	return true;
+}
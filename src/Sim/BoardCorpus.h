@@ -0,0 +1,60 @@
+#pragma once
+#include "Game/Board.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/*
+ * Fixed boards to measure flood fills on.
+ *
+ * Random boards rarely stress Board::open: cascades are short and shapeless.
+ * Next to a couple of canonical layouts, the corpus holds adversarial ones:
+ * corridors long enough to cross the whole board, and patterns that break
+ * every row into many short runs, the worst case of a scanline fill.
+ *
+ * The file is a small header followed by the entries, each one a header and
+ * the mined layer of its board, one bit per cell like saves. Every section is
+ * a whole number of 64 bits words.
+ */
+namespace BoardCorpus
+{
+
+inline const std::filesystem::path DEFAULT_PATH = "corpus.mpc";
+
+enum class Layout : std::uint8_t
+{
+	Empty,      // no mine at all, one cascade opens everything
+	Random,     // 16% of mines, from the generator
+	Spiral,     // a corridor winding to the center
+	Serpentine, // a corridor going back and forth, row after row
+	Comb,       // a corridor along the top, teeth hanging down from it
+	Lattice,    // a mine every 4 cells on both axes: rows split into many runs
+	Diagonal,   // diagonal mine lines: empty cells only touch diagonally
+	Count
+};
+
+std::string_view getName(Layout layout);
+
+struct Entry
+{
+	Layout layout;
+	Vec2s size;
+	std::size_t start; // cell without any mine around, where the cascade starts
+	std::vector<std::uint64_t> mined; // as Board::exportLayer
+};
+
+// Random layouts draw from 'gen'. Returns false if the board is too small for
+// the layout, or has no cell to start from.
+bool generate(Layout layout, const Vec2s& size, Entry& entry);
+
+// Rebuilds the unopened board.
+bool makeBoard(const Entry& entry, Board& board);
+
+bool save(const std::filesystem::path& file, std::span<const Entry> entries);
+// Leaves 'entries' untouched on failure.
+bool load(const std::filesystem::path& file, std::vector<Entry>& entries);
+
+} // namespace BoardCorpus
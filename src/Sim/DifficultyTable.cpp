@@ -0,0 +1,138 @@
+#include "DifficultyTable.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+
+struct Position
+{
+	std::size_t index; // lower bound, the upper one is index + 1 (or itself on a one entry axis)
+	double t;          // weight of the upper bound
+};
+
+// Where 'value' sits on an increasing axis, clamped to its ends.
+// 'transform' maps both to the space the interpolation is linear in.
+template <class Transform>
+Position locate(std::span<const float> axis, double value, Transform&& transform)
+{
+	if (axis.size() < 2 || value <= axis.front())
+		return {0, 0.0};
+	if (value >= axis.back())
+		return {axis.size() - 2, 1.0};
+
+	std::size_t i = std::size_t(std::upper_bound(axis.begin(), axis.end(), float(value)) - axis.begin()) - 1;
+	double lo = transform(axis[i]), hi = transform(axis[i + 1]);
+	return {i, (transform(value) - lo) / (hi - lo)};
+}
+
+} // namespace
+
+DifficultyTable::DifficultyTable(const std::filesystem::path& file)
+	: file_(file)
+{
+	auto bytes = file_.bytes();
+	if (bytes.size() < sizeof(Header))
+		throw std::runtime_error("Missing or truncated difficulty table: " + file.string());
+
+	auto* header = reinterpret_cast<const Header*>(bytes.data());
+	if (header->magic != MAGIC || header->version != VERSION)
+		throw std::runtime_error("Unsupported difficulty table: " + file.string());
+
+	std::size_t sides = header->sideCount, densities = header->densityCount;
+	std::size_t floats = sides + densities + sides * sides * densities;
+	if (!sides || !densities || bytes.size() != sizeof(Header) + floats * sizeof(float))
+		throw std::runtime_error("Corrupted difficulty table: " + file.string());
+
+	auto* data = reinterpret_cast<const float*>(bytes.data() + sizeof(Header));
+	sides_ = {data, sides};
+	densities_ = {data + sides, densities};
+	winRates_ = {data + sides + densities, sides * sides * densities};
+}
+
+double DifficultyTable::at(std::size_t a, std::size_t b, std::size_t d) const
+{
+	return winRates_[(a * sides_.size() + b) * densities_.size() + d];
+}
+
+double DifficultyTable::winRate(std::size_t width, std::size_t height, std::size_t mineCount) const
+{
+	double cells = double(width) * double(height);
+	if (cells <= 0.0)
+		return 0.0;
+
+	// Win rates follow the board size geometrically, densities linearly
+	auto log = [](double x) { return std::log2(x); };
+	auto identity = [](double x) { return x; };
+	auto a = locate(sides_, double(std::min(width, height)), log);
+	auto b = locate(sides_, double(std::max(width, height)), log);
+	auto d = locate(densities_, double(mineCount) / cells, identity);
+
+	// Trilinear interpolation, the axes having at least one entry each
+	auto next = [](std::span<const float> axis, std::size_t i) { return std::min(i + 1, axis.size() - 1); };
+	double rate = 0.0;
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		double weight = (corner & 1 ? a.t : 1.0 - a.t)
+		                * (corner & 2 ? b.t : 1.0 - b.t)
+		                * (corner & 4 ? d.t : 1.0 - d.t);
+		if (weight == 0.0)
+			continue;
+
+		rate += weight * at(corner & 1 ? next(sides_, a.index) : a.index,
+		                    corner & 2 ? next(sides_, b.index) : b.index,
+		                    corner & 4 ? next(densities_, d.index) : d.index);
+	}
+
+	// Past the table, the board counts as independent copies of the simulated one
+	auto clampSide = [&](std::size_t side) { return std::clamp(double(side), double(sides_.front()), double(sides_.back())); };
+	double simulated = clampSide(std::min(width, height)) * clampSide(std::max(width, height));
+	if (cells > simulated)
+		rate = std::pow(rate, cells / simulated);
+
+	return std::clamp(rate, 0.0, 1.0);
+}
+
+bool DifficultyTable::write(const std::filesystem::path& file,
+                            std::span<const float> sides,
+                            std::span<const float> densities,
+                            std::span<const float> winRates)
+{
+	if (winRates.size() != sides.size() * sides.size() * densities.size())
+		return false;
+
+	Header header
+	{
+		.magic = MAGIC,
+		.version = VERSION,
+		.sideCount = std::uint32_t(sides.size()),
+		.densityCount = std::uint32_t(densities.size())
+	};
+
+	// Written aside then swapped in, like saves: the game refuses to start on
+	// a truncated table
+	std::filesystem::path temp = file;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(sides.data()), std::streamsize(sides.size_bytes()));
+		out.write(reinterpret_cast<const char*>(densities.data()), std::streamsize(densities.size_bytes()));
+		out.write(reinterpret_cast<const char*>(winRates.data()), std::streamsize(winRates.size_bytes()));
+		// Checked once closed, the last buffer flushed
+		out.close();
+		if (out.fail())
+		{
+			std::error_code error;
+			std::filesystem::remove(temp, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, file, error);
+	return !error;
+}
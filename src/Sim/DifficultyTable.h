@@ -0,0 +1,50 @@
+#pragma once
+#include "Utils/MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+/*
+ * Measured chances of winning a board, as played by the headless Player.
+ *
+ * The file is a small header followed by three float arrays: the simulated
+ * side lengths, the simulated mine densities, then the win rates indexed by
+ * [side][side][density] (symmetric in the two sides). It is memory-mapped and
+ * used in place, little-endian like every platform the game runs on.
+ */
+class DifficultyTable
+{
+public:
+
+	static constexpr std::uint32_t MAGIC = 0x5444504D; // "MPDT"
+	static constexpr std::uint32_t VERSION = 1;
+
+	struct Header
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t sideCount;
+		std::uint32_t densityCount;
+	};
+
+	// Throws std::runtime_error if the file is missing or malformed.
+	explicit DifficultyTable(const std::filesystem::path& file);
+
+	// Interpolated between the simulated boards. Past the largest one, the board
+	// is treated as several independent largest boards: their win rates multiply.
+	double winRate(std::size_t width, std::size_t height, std::size_t mineCount) const;
+
+	// Used by the generator. 'winRates' has sides.size()^2 * densities.size() entries.
+	static bool write(const std::filesystem::path& file,
+	                  std::span<const float> sides,
+	                  std::span<const float> densities,
+	                  std::span<const float> winRates);
+
+private:
+
+	double at(std::size_t a, std::size_t b, std::size_t d) const;
+
+	MappedFile file_;
+	std::span<const float> sides_, densities_, winRates_;
+};
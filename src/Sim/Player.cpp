@@ -0,0 +1,135 @@
+#include "Player.h"
+#include "Utils/MyRandom.h"
+#include <algorithm>
+
+Player::Result Player::play(Board& board)
+{
+	board.clear();
+	board.placeMines();
+
+	// Same first click rule as the game: the clicked cell is made safe
+	Vec2s size = board.getSize();
+	std::size_t next = board.toIndex({size.x / 2, size.y / 2});
+	board.makeSafe(next);
+
+	Result result{.won = false, .guesses = 0};
+	while (!board.open(next))
+	{
+		while (!board.isWon() && deduce(board)) {}
+
+		if (board.isWon())
+		{
+			result.won = true;
+			break;
+		}
+
+		next = pickGuess(board);
+		++result.guesses;
+	}
+	return result;
+}
+
+bool Player::deduce(Board& board)
+{
+	bool progress = false;
+	auto& cells = board.getCells();
+	for (std::size_t i = 0; i < cells.size(); ++i)
+	{
+		const Cell& cell = cells[i];
+		if (!cell.opened || cell.mined || !cell.adjacentMines)
+			continue;
+
+		// The range includes the cell itself, which is opened: it counts for neither
+		auto neighbours = board.getNeighboursOf(board.toCoordinates(i));
+		std::size_t flagged = 0, unknown = 0;
+		for (auto& coo : neighbours)
+		{
+			const Cell& nb = cells[board.toIndex(coo)];
+			flagged += nb.flagged;
+			unknown += !nb.opened && !nb.flagged;
+		}
+
+		if (!unknown)
+			continue;
+
+		if (flagged == cell.adjacentMines)
+		{
+			// Chording opens every unknown neighbour at once
+			board.open(i);
+			progress = true;
+		}
+		else if (flagged + unknown == cell.adjacentMines)
+		{
+			for (auto& coo : neighbours)
+			{
+				std::size_t idx = board.toIndex(coo);
+				if (!cells[idx].opened && !cells[idx].flagged)
+					board.flag(idx);
+			}
+			progress = true;
+		}
+	}
+	return progress;
+}
+
+std::size_t Player::pickGuess(const Board& board)
+{
+	auto& cells = board.getCells();
+
+	// Local risk of an unknown cell: the worst ratio of missing mines over
+	// unknown cells among the numbers touching it. Negative if no number does.
+	risk_.assign(cells.size(), -1.f);
+	for (std::size_t i = 0; i < cells.size(); ++i)
+	{
+		const Cell& cell = cells[i];
+		if (!cell.opened || !cell.adjacentMines)
+			continue;
+
+		auto neighbours = board.getNeighboursOf(board.toCoordinates(i));
+		std::size_t flagged = 0, unknown = 0;
+		for (auto& coo : neighbours)
+		{
+			const Cell& nb = cells[board.toIndex(coo)];
+			flagged += nb.flagged;
+			unknown += !nb.opened && !nb.flagged;
+		}
+
+		if (!unknown)
+			continue;
+
+		float ratio = float(cell.adjacentMines - flagged) / float(unknown);
+		for (auto& coo : neighbours)
+		{
+			std::size_t idx = board.toIndex(coo);
+			if (!cells[idx].opened && !cells[idx].flagged)
+				risk_[idx] = std::max(risk_[idx], ratio);
+		}
+	}
+
+	// Cells away from any number share the remaining mine density
+	std::size_t unknownCount = cells.size() - board.getOpenCount() - board.getFlagCount();
+	float density = float(board.getMineCount() - board.getFlagCount()) / float(unknownCount);
+
+	// Ties are broken uniformly (reservoir sampling) so the player has no
+	// positional bias, which would skew the statistics on some layouts.
+	std::size_t best = 0, ties = 0;
+	float bestRisk = 2.f;
+	for (std::size_t i = 0; i < cells.size(); ++i)
+	{
+		if (cells[i].opened || cells[i].flagged)
+			continue;
+
+		float r = risk_[i] < 0.f ? density : risk_[i];
+		if (r < bestRisk)
+		{
+			bestRisk = r;
+			best = i;
+			ties = 1;
+		}
+		else if (r == bestRisk && randomBelow(++ties) == 0)
+		{
+			best = i;
+		}
+	}
+	return best;
+}
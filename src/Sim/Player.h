@@ -0,0 +1,39 @@
+#pragma once
+#include "Game/Board.h"
+#include <cstddef>
+#include <vector>
+
+/*
+ * Headless logic-and-guess player.
+ * Plays whole games on a Board, the way a careful human would: it applies the
+ * two single-cell rules (every mine found: open the rest, every unknown is a
+ * mine: flag them) until stuck, then guesses the least risky unknown cell.
+ * Draws its randomness from the calling thread's generator.
+ */
+class Player
+{
+public:
+
+	struct Result
+	{
+		bool won;
+		std::size_t guesses; // excluding the first click, which is always safe
+	};
+
+	// The board must be sized and have its mine count set.
+	// Mines are placed by this call, the first click is made at the center.
+	Result play(Board& board);
+
+private:
+
+	// Applies the single-cell rules over the whole board.
+	// Returns false if nothing could be deduced.
+	bool deduce(Board& board);
+
+	// Returns the index of the unknown cell least likely to hold a mine.
+	std::size_t pickGuess(const Board& board);
+
+private:
+
+	std::vector<float> risk_; // scratch, kept between games to not reallocate
+};
@@ -0,0 +1,72 @@
+#include "Simulation.h"
+#include "Player.h"
+#include "Utils/MyRandom.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr std::size_t BATCH_SIZE = 64;
+
+} // namespace
+
+SimulationResult simulate(const SimulationParams& params)
+{
+	unsigned threadCount = params.threads ? params.threads : std::max(1u, std::thread::hardware_concurrency());
+	std::size_t batchCount = (params.games + BATCH_SIZE - 1) / BATCH_SIZE;
+	threadCount = unsigned(std::min<std::size_t>(threadCount, std::max<std::size_t>(batchCount, 1)));
+
+	std::atomic<std::size_t> nextBatch = 0;
+	std::vector<SimulationResult> partials(threadCount, SimulationResult{});
+
+	auto worker = [&](SimulationResult& partial)
+	{
+		Board board;
+		board.resize(params.size);
+		board.setMineCount(params.mineCount);
+		Player player;
+
+		for (std::size_t batch; (batch = nextBatch.fetch_add(1, std::memory_order_relaxed)) < batchCount;)
+		{
+			gen.seed(mix(params.seed ^ mix(batch)));
+			std::size_t first = batch * BATCH_SIZE;
+			std::size_t last = std::min(first + BATCH_SIZE, params.games);
+
+			auto start = std::chrono::steady_clock::now();
+			for (std::size_t game = first; game < last; ++game)
+			{
+				auto result = player.play(board);
+				partial.wins += result.won;
+				partial.guesses += result.guesses;
+			}
+			partial.playTime += std::chrono::steady_clock::now() - start;
+			partial.games += last - first;
+		}
+		partial.counters = board.getCounters();
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		// The calling thread takes its share too
+		std::vector<std::jthread> threads;
+		threads.reserve(threadCount - 1);
+		for (unsigned t = 1; t < threadCount; ++t)
+			threads.emplace_back(worker, std::ref(partials[t]));
+		worker(partials[0]);
+	}
+
+	SimulationResult total{};
+	total.wallTime = std::chrono::steady_clock::now() - start;
+	for (auto& partial : partials)
+	{
+		total.games += partial.games;
+		total.wins += partial.wins;
+		total.guesses += partial.guesses;
+		total.playTime += partial.playTime;
+		total.counters += partial.counters;
+	}
+	return total;
+}
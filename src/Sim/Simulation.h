@@ -0,0 +1,33 @@
+#pragma once
+#include "Game/Board.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct SimulationParams
+{
+	Vec2s size;
+	std::size_t mineCount;
+	std::size_t games;
+	unsigned threads;   // 0 for one per hardware thread
+	std::uint64_t seed; // same seed, same results, whatever the thread count
+};
+
+struct SimulationResult
+{
+	std::size_t games, wins, guesses;
+	std::chrono::nanoseconds wallTime; // whole batch
+	std::chrono::nanoseconds playTime; // summed over every thread
+	Board::Counters counters; // over every game
+
+	double winRate() const { return games ? double(wins) / double(games) : 0.0; }
+	double guessesPerGame() const { return games ? double(guesses) / double(games) : 0.0; }
+	double nanosecondsPerGame() const { return games ? double(playTime.count()) / double(games) : 0.0; }
+};
+
+/*
+ * Plays 'games' complete games with the headless Player, spread over threads.
+ * Games are handed out in fixed batches, each with its own seed, so a given
+ * seed always plays the exact same games.
+ */
+SimulationResult simulate(const SimulationParams& params);
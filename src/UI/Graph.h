@@ -0,0 +1,14 @@
+#pragma once
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <span>
+
+// Bar graph, one pixel wide bar per value, oldest on the left.
+struct Graph
+{
+	sf::IntRect rect;
+	std::span<const float> values;
+	float maxValue;      // at the top of the rect, taller bars are clipped
+	float markValue = 0; // drawn as a horizontal line, if positive
+	sf::Color color = sf::Color::White;
+};
@@ -3,6 +3,7 @@
 #include "Button.h"
 #include "NumberField.h"
 #include "Cursor.h"
+#include "Graph.h"
 #include <SFML/System/Utf.hpp>
 #include <algorithm>
 
@@ -17,6 +18,8 @@ constexpr sf::Color OUTLINE_COLOR = sf::Color::Black;
 constexpr int CURSOR_WIDTH = 2;
 constexpr int CURSOR_DIST_FROM_TEXT = 2;
 constexpr float RECT_OUTLINE_THICKNESS = 2.f;
+constexpr sf::Color GRAPH_BACKGROUND = {0x00, 0x00, 0x00, 0x80};
+constexpr sf::Color GRAPH_MARK_COLOR = {0xFF, 0x40, 0x40, 0xFF};
 
 // Writes the two triangles of a glyph quad. 'out' must have room for 6 vertices.
 void writeGlyphQuad(sf::Vertex* out, const sf::Glyph& glyph, sf::Vector2f pen, sf::Color color)
@@ -254,3 +257,39 @@ void UITarget::draw(const Cursor& cursor)
 	target_.draw(rect_);
 	rect_.setOutlineThickness(RECT_OUTLINE_THICKNESS);
 }
+
+void UITarget::draw(const Graph& graph)
+{
+	sf::FloatRect rect(graph.rect);
+	rect_.setPosition(rect.position);
+	rect_.setSize(rect.size);
+	rect_.setFillColor(GRAPH_BACKGROUND);
+	rect_.setOutlineThickness(0.f);
+	target_.draw(rect_);
+
+	// Bars are lines from the bottom edge, batched on the stack
+	std::array<sf::Vertex, BAR_CAPACITY * 2> bars;
+	std::size_t count = std::min(graph.values.size(), std::size_t(graph.rect.size.x));
+	float bottom = rect.position.y + rect.size.y;
+	for (std::size_t first = 0; first < count; first += BAR_CAPACITY)
+	{
+		std::size_t batch = std::min(BAR_CAPACITY, count - first);
+		for (std::size_t i = 0; i < batch; ++i)
+		{
+			float x = rect.position.x + float(first + i) + 0.5f;
+			float height = std::clamp(graph.values[first + i] / graph.maxValue, 0.f, 1.f) * rect.size.y;
+			bars[i * 2] = {{x, bottom}, graph.color};
+			bars[i * 2 + 1] = {{x, bottom - height}, graph.color};
+		}
+		target_.draw(bars.data(), batch * 2, sf::PrimitiveType::Lines);
+	}
+
+	if (graph.markValue > 0.f && graph.markValue < graph.maxValue)
+	{
+		rect_.setSize({rect.size.x, 1.f});
+		rect_.setPosition({rect.position.x, bottom - graph.markValue / graph.maxValue * rect.size.y});
+		rect_.setFillColor(GRAPH_MARK_COLOR);
+		target_.draw(rect_);
+	}
+	rect_.setOutlineThickness(RECT_OUTLINE_THICKNESS);
+}
@@ -23,12 +23,14 @@ public:
 	void draw(const Text& text);
 	void draw(const struct NumberField& field);
 	void draw(const struct Cursor& cursor);
+	void draw(const struct Graph& graph);
 
 private:
 
 	static constexpr std::size_t VERTICES_PER_GLYPH = 6;
 	static constexpr std::size_t GLYPH_CAPACITY = 32; // Trade memory for draw calls
 	static constexpr std::size_t VERTEX_CAPACITY = GLYPH_CAPACITY * VERTICES_PER_GLYPH;
+	static constexpr std::size_t BAR_CAPACITY = 128; // bars per draw call
 
 	void addGlyph(const sf::Glyph& fillGlyph, const sf::Glyph& outlineGlyph, sf::Vector2f pen, sf::Color color);
 	void flushText();
@@ -0,0 +1,91 @@
+#include "AllocationTracker.h"
+
+#ifdef MPP_TRACK_ALLOCATIONS
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+struct alignas(64) TagCounts // one cache line each, threads tagging differently do not share
+{
+	std::atomic<std::uint64_t> allocations;
+	std::atomic<std::uint64_t> bytes;
+};
+
+constinit std::array<TagCounts, AllocationTracker::TAG_COUNT> counts{};
+constinit thread_local std::uint8_t currentTag = AllocationTracker::UNTAGGED;
+
+void* allocate(std::size_t size, std::size_t alignment)
+{
+	auto& tag = counts[currentTag];
+	tag.allocations.fetch_add(1, std::memory_order_relaxed);
+	tag.bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (size == 0)
+		size = 1;
+
+	void* p;
+#ifdef _WIN32
+	p = alignment > alignof(std::max_align_t) ? _aligned_malloc(size, alignment) : std::malloc(size);
+#else
+	p = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) : std::malloc(size);
+#endif // _WIN32
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void deallocate(void* p, std::size_t alignment)
+{
+#ifdef _WIN32
+	if (alignment > alignof(std::max_align_t))
+	{
+		_aligned_free(p);
+		return;
+	}
+#endif // _WIN32
+	std::free(p);
+}
+
+} // namespace
+
+AllocationTracker::Counts AllocationTracker::get(std::uint8_t tag)
+{
+	return
+	{
+		.allocations = counts[tag].allocations.load(std::memory_order_relaxed),
+		.bytes = counts[tag].bytes.load(std::memory_order_relaxed)
+	};
+}
+
+AllocationTracker::Counts AllocationTracker::getTotal()
+{
+	Counts total{};
+	for (std::size_t tag = 0; tag < TAG_COUNT; ++tag)
+	{
+		Counts tagCounts = get(std::uint8_t(tag));
+		total.allocations += tagCounts.allocations;
+		total.bytes += tagCounts.bytes;
+	}
+	return total;
+}
+
+std::uint8_t AllocationTracker::setTag(std::uint8_t tag)
+{
+	std::uint8_t previous = currentTag;
+	currentTag = tag < TAG_COUNT ? tag : UNTAGGED;
+	return previous;
+}
+
+// Replaceable allocation functions. The nothrow, sized and array forms all
+// forward to these in the standard library.
+void* operator new(std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, std::size_t(alignment)); }
+void operator delete(void* p) noexcept { deallocate(p, alignof(std::max_align_t)); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { deallocate(p, std::size_t(alignment)); }
+
+#endif // MPP_TRACK_ALLOCATIONS
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Counts heap allocations, by tag, through a replacement of the global
+ * operator new. Only compiled in with MPP_TRACK_ALLOCATIONS: otherwise every
+ * function below is an empty inline and new is left alone.
+ *
+ * A tag is a small number set per thread, with a Scope, which the callers
+ * give a meaning to. The frame profiler tags allocations with its stages.
+ */
+namespace AllocationTracker
+{
+
+constexpr std::size_t TAG_COUNT = 16;
+constexpr std::uint8_t UNTAGGED = TAG_COUNT - 1;
+
+struct Counts
+{
+	std::uint64_t allocations;
+	std::uint64_t bytes;
+};
+
+#ifdef MPP_TRACK_ALLOCATIONS
+
+constexpr bool ENABLED = true;
+
+// Since the start of the program
+Counts get(std::uint8_t tag);
+Counts getTotal();
+
+// Returns the previous tag of the thread.
+std::uint8_t setTag(std::uint8_t tag);
+
+#else
+
+constexpr bool ENABLED = false;
+
+inline Counts get(std::uint8_t) { return {}; }
+inline Counts getTotal() { return {}; }
+inline std::uint8_t setTag(std::uint8_t) { return UNTAGGED; }
+
+#endif // MPP_TRACK_ALLOCATIONS
+
+class Scope
+{
+public:
+
+	explicit Scope(std::uint8_t tag) : previous_(setTag(tag)) {}
+	~Scope() { setTag(previous_); }
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+
+	std::uint8_t previous_;
+};
+
+} // namespace AllocationTracker
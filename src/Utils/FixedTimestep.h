@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Cuts the variable time between frames into fixed steps, the remainder
+ * carried over to the next frame. Whatever the frame rate, the simulation
+ * sees the same steps; the frame only interpolates between the last two.
+ *
+ * A frame never runs more than 'maxSteps': time beyond is dropped, the
+ * simulation slows down instead of spiralling behind a slow frame.
+ */
+class FixedTimestep
+{
+public:
+
+	FixedTimestep(std::chrono::nanoseconds step, int maxSteps)
+		: step_(step)
+		, maxSteps_(maxSteps)
+		, accumulated_{}
+	{}
+
+	// Steps to run for 'elapsed' more time.
+	int advance(std::chrono::nanoseconds elapsed)
+	{
+		accumulated_ += elapsed;
+		auto steps = std::min<std::int64_t>(accumulated_ / step_, maxSteps_);
+		accumulated_ = std::min(accumulated_ - steps * step_, step_ - std::chrono::nanoseconds(1));
+		return int(steps);
+	}
+
+	// How far past the last step the frame is, in [0, 1): the weight of the
+	// last step against the one before.
+	float getAlpha() const { return float(accumulated_.count()) / float(step_.count()); }
+	float getStepSeconds() const { return std::chrono::duration<float>(step_).count(); }
+
+private:
+
+	std::chrono::nanoseconds step_;
+	int maxSteps_;
+	std::chrono::nanoseconds accumulated_;
+};
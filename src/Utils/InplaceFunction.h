@@ -0,0 +1,86 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <class Signature, std::size_t Capacity = 4 * sizeof(void*)>
+class InplaceFunction;
+
+/*
+ * std::function without the heap: the callable is stored inside, and one that
+ * does not fit fails to compile instead of allocating.
+ */
+template <class R, class... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+
+	InplaceFunction() = default;
+
+	template <class F>
+		requires (!std::same_as<std::decay_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+	InplaceFunction(F&& f)
+	{
+		using Callable = std::decay_t<F>;
+		static_assert(sizeof(Callable) <= Capacity, "Callable too large, raise the capacity");
+		static_assert(alignof(Callable) <= alignof(std::max_align_t));
+
+		new (storage_) Callable(std::forward<F>(f));
+		invoke_ = [](void* storage, Args... args) -> R
+		{
+			return (*std::launder(static_cast<Callable*>(storage)))(std::forward<Args>(args)...);
+		};
+		manage_ = [](void* dst, void* src)
+		{
+			auto* callable = std::launder(static_cast<Callable*>(src));
+			if (dst)
+				new (dst) Callable(std::move(*callable));
+			callable->~Callable();
+		};
+	}
+
+	InplaceFunction(InplaceFunction&& other) noexcept
+		: invoke_(other.invoke_)
+		, manage_(other.manage_)
+	{
+		if (manage_)
+			manage_(storage_, other.storage_);
+		other.invoke_ = nullptr;
+		other.manage_ = nullptr;
+	}
+
+	InplaceFunction& operator=(InplaceFunction&& other) noexcept
+	{
+		if (this != &other)
+		{
+			this->~InplaceFunction();
+			new (this) InplaceFunction(std::move(other));
+		}
+		return *this;
+	}
+
+	InplaceFunction(const InplaceFunction&) = delete;
+	InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+	~InplaceFunction()
+	{
+		if (manage_)
+			manage_(nullptr, storage_);
+	}
+
+	explicit operator bool() const { return invoke_ != nullptr; }
+
+	R operator()(Args... args)
+	{
+		return invoke_(storage_, std::forward<Args>(args)...);
+	}
+
+private:
+
+	alignas(std::max_align_t) std::byte storage_[Capacity];
+	R (*invoke_)(void*, Args...) = nullptr;
+	// Moves the callable into 'dst' if not null, then destroys it
+	void (*manage_)(void* dst, void* src) = nullptr;
+};
@@ -0,0 +1,149 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace
+{
+
+// Which pool the thread works for, and as which worker
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local std::size_t currentWorker = 0;
+
+} // namespace
+
+JobSystem::JobSystem()
+	: JobSystem(std::max(1u, std::thread::hardware_concurrency()))
+{}
+
+JobSystem::JobSystem(unsigned threads)
+	: epoch_(0)
+	, joined_(0)
+	, nextWorker_(0)
+{
+	// All built before any starts: workers steal from each other
+	for (unsigned w = 1; w < threads; ++w)
+		workers_.push_back(std::make_unique<Worker>());
+	for (std::size_t w = 0; w < workers_.size(); ++w)
+		workers_[w]->thread = std::jthread([this, w](std::stop_token stop) { run(w, stop); });
+}
+
+JobSystem::~JobSystem()
+{
+	for (auto& worker : workers_)
+		worker->thread.request_stop();
+	epoch_.fetch_add(1, std::memory_order_release);
+	epoch_.notify_all();
+	for (auto& worker : workers_)
+		worker->thread.join();
+}
+
+void JobSystem::submit(Job job)
+{
+	if (workers_.empty())
+	{
+		job();
+		return;
+	}
+
+	// A worker keeps what it spawns, the others spread it around
+	std::size_t self = getSelf();
+	std::size_t target = self < workers_.size() ? self : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+	{
+		std::lock_guard lock(workers_[target]->mutex);
+		workers_[target]->jobs.push_back(std::move(job));
+	}
+	epoch_.fetch_add(1, std::memory_order_release);
+	epoch_.notify_one();
+}
+
+void JobSystem::run(std::size_t self, std::stop_token stop)
+{
+	currentSystem = this;
+	currentWorker = self;
+	while (!stop.stop_requested())
+	{
+		// Read before looking for work: a job submitted after the look changes it
+		std::uint32_t seen = epoch_.load(std::memory_order_acquire);
+		if (!runOne(self))
+			epoch_.wait(seen, std::memory_order_acquire);
+	}
+}
+
+bool JobSystem::runOne(std::size_t self)
+{
+	Job job;
+	if (self < workers_.size())
+	{
+		Worker& own = *workers_[self];
+		std::lock_guard lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+		}
+	}
+
+	// Oldest first from the others: the largest pieces of work, usually
+	for (std::size_t i = 1; !job && i <= workers_.size(); ++i)
+	{
+		Worker& victim = *workers_[(self + i) % workers_.size()];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+		}
+	}
+
+	if (!job)
+		return false;
+	job();
+	return true;
+}
+
+std::size_t JobSystem::getSelf() const
+{
+	return currentSystem == this ? currentWorker : workers_.size();
+}
+
+void JobSystem::Range::runChunks()
+{
+	for (std::size_t begin; (begin = next.fetch_add(grain, std::memory_order_relaxed)) < last;)
+		call(fn, begin, std::min(begin + grain, last));
+}
+
+void JobSystem::forkJoin(Range& range)
+{
+	// As many helpers as there are chunks for, the caller takes one share
+	std::size_t chunks = (range.last - range.first + range.grain - 1) / range.grain;
+	std::size_t helpers = std::min(chunks - 1, workers_.size());
+	range.helpers.store(helpers, std::memory_order_relaxed);
+	for (std::size_t h = 0; h < helpers; ++h)
+	{
+		submit([this, &range]
+		{
+			range.runChunks();
+			// Last touch of the range: the caller may return as soon as it
+			// sees zero, so the wake up goes through the system, which outlives it
+			if (range.helpers.fetch_sub(1) == 1)
+			{
+				joined_.fetch_add(1);
+				joined_.notify_all();
+			}
+		});
+	}
+
+	range.runChunks();
+
+	// Helpers not started yet are run here rather than waited for, along with
+	// whatever else is queued
+	std::size_t self = getSelf();
+	while (true)
+	{
+		// Read before the count: the last helper bumps it after the count
+		std::uint32_t seen = joined_.load();
+		if (range.helpers.load() == 0)
+			break;
+		if (!runOne(self))
+			joined_.wait(seen);
+	}
+}
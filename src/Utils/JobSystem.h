@@ -0,0 +1,98 @@
+#pragma once
+#include "InplaceFunction.h"
+#include "NotCopyable.h"
+#include "NotMovable.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Small work-stealing thread pool.
+ *
+ * Every worker owns a queue: it takes its own jobs from the back, newest first
+ * while they are warm in cache, and steals from the front of the others once
+ * it runs dry. Workers with nothing to do block on a counter bumped by every
+ * submission, they never spin.
+ *
+ * parallelFor forks a range over the workers and the calling thread, which
+ * runs jobs too while it waits for the others: it can be called from a job.
+ */
+class JobSystem : NotCopyable, NotMovable
+{
+public:
+
+	using Job = InplaceFunction<void(), 6 * sizeof(void*)>;
+
+	// One thread per hardware thread, the caller of parallelFor included.
+	JobSystem();
+	// 'threads' counts the caller: one thread means no worker at all.
+	explicit JobSystem(unsigned threads);
+	// Jobs still queued are dropped, running ones are waited for.
+	~JobSystem();
+
+	unsigned getThreadCount() const { return unsigned(workers_.size()) + 1; }
+
+	// Any thread. Runs right away, on the caller, without workers.
+	void submit(Job job);
+
+	// Calls 'fn(i)' for every i in [first, last), handing out 'grain' indices at
+	// a time, and returns once all calls are done.
+	template <class F>
+	void parallelFor(std::size_t first, std::size_t last, std::size_t grain, F&& fn);
+
+private:
+
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+		std::jthread thread;
+	};
+
+	// Chunks of a parallelFor, claimed by whoever comes first.
+	struct Range
+	{
+		std::size_t first, last, grain;
+		std::atomic<std::size_t> next;
+		std::atomic<std::size_t> helpers; // jobs still running or queued
+		void (*call)(void* fn, std::size_t first, std::size_t last);
+		void* fn;
+
+		void runChunks();
+	};
+
+	void run(std::size_t self, std::stop_token stop);
+	// Takes a job from 'self' if it is a worker, or steals one. False if none.
+	bool runOne(std::size_t self);
+	std::size_t getSelf() const;
+	void forkJoin(Range& range);
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::atomic<std::uint32_t> epoch_; // bumped by every submission, what idle workers wait on
+	// Bumped by the last helper of every range, what forkJoin waits on: the
+	// range itself may be gone as soon as its helpers count reads zero.
+	std::atomic<std::uint32_t> joined_;
+	std::atomic<std::size_t> nextWorker_; // round robin of outside submissions
+};
+
+template <class F>
+void JobSystem::parallelFor(std::size_t first, std::size_t last, std::size_t grain, F&& fn)
+{
+	if (first >= last)
+		return;
+
+	Range range{.first = first, .last = last, .grain = grain ? grain : 1, .next = first, .helpers = 0,
+	            .call = [](void* f, std::size_t begin, std::size_t end)
+	            {
+	                for (std::size_t i = begin; i < end; ++i)
+	                    (*static_cast<std::remove_reference_t<F>*>(f))(i);
+	            },
+	            .fn = const_cast<void*>(static_cast<const void*>(std::addressof(fn)))};
+	forkJoin(range);
+}
@@ -0,0 +1,122 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	// An empty file cannot be mapped
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+
+	file_ = file;
+	mapping_ = mapping;
+	data_ = static_cast<const std::byte*>(view);
+	size_ = std::size_t(size.QuadPart);
+}
+
+void MappedFile::close()
+{
+	if (!data_)
+		return;
+
+	UnmapViewOfFile(data_);
+	CloseHandle(mapping_);
+	CloseHandle(file_);
+	data_ = nullptr;
+	size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	// An empty file cannot be mapped
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* view = mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view != MAP_FAILED)
+		{
+			data_ = static_cast<const std::byte*>(view);
+			size_ = std::size_t(st.st_size);
+		}
+	}
+
+	// The mapping keeps its own reference to the file
+	::close(fd);
+}
+
+void MappedFile::close()
+{
+	if (!data_)
+		return;
+
+	munmap(const_cast<std::byte*>(data_), size_);
+	data_ = nullptr;
+	size_ = 0;
+}
+
+#endif // _WIN32
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: data_(std::exchange(other.data_, nullptr))
+	, size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+	, file_(std::exchange(other.file_, nullptr))
+	, mapping_(std::exchange(other.mapping_, nullptr))
+#endif // _WIN32
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		data_ = std::exchange(other.data_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+		file_ = std::exchange(other.file_, nullptr);
+		mapping_ = std::exchange(other.mapping_, nullptr);
+#endif // _WIN32
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+/*
+ * Read-only memory mapping of a whole file.
+ * Pages are loaded by the OS on first access, nothing is copied up front.
+ */
+class MappedFile
+{
+public:
+
+	MappedFile() = default;
+	explicit MappedFile(const std::filesystem::path& path); // isOpen() tells if it worked
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool isOpen() const { return data_ != nullptr; }
+	std::span<const std::byte> bytes() const { return {data_, size_}; }
+
+private:
+
+	void close();
+
+	const std::byte* data_ = nullptr;
+	std::size_t size_ = 0;
+#ifdef _WIN32
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#endif // _WIN32
+};
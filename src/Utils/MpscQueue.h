@@ -0,0 +1,89 @@
+#pragma once
+#include "NotCopyable.h"
+#include "NotMovable.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+
+/*
+ * Bounded multi producer, single consumer queue, lock-free.
+ *
+ * A ring of slots each tagged with a sequence number, after D. Vyukov's bounded
+ * queue: producers claim the tail slot with a compare-exchange, then publish
+ * it by bumping its sequence; the consumer alone owns the head. A full queue
+ * is reported to the producer rather than waited on.
+ */
+template <class T, std::size_t Capacity>
+class MpscQueue : NotCopyable, NotMovable
+{
+	static_assert(Capacity >= 2 && std::has_single_bit(Capacity), "Capacity must be a power of two");
+
+public:
+
+	MpscQueue()
+	{
+		for (std::size_t i = 0; i < Capacity; ++i)
+			slots_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// Any thread. Returns false if the queue is full, 'args' are then unused.
+	template <class... Args>
+	bool tryPush(Args&&... args)
+	{
+		std::size_t tail = tail_.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Slot& slot = slots_[tail % Capacity];
+			std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			auto lag = std::ptrdiff_t(sequence - tail);
+			if (lag == 0)
+			{
+				// Free, and nobody claimed it since 'tail' was read
+				if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+				{
+					slot.value = T{std::forward<Args>(args)...};
+					slot.sequence.store(tail + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (lag < 0)
+			{
+				// Still holding what was pushed a lap ago
+				return false;
+			}
+			else
+			{
+				tail = tail_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer thread only. Returns false if empty, or if the oldest slot is
+	// claimed but not published yet.
+	bool tryPop(T& out)
+	{
+		Slot& slot = slots_[head_ % Capacity];
+		if (slot.sequence.load(std::memory_order_acquire) != head_ + 1)
+			return false;
+
+		out = std::exchange(slot.value, T{});
+		slot.sequence.store(head_ + Capacity, std::memory_order_release);
+		++head_;
+		return true;
+	}
+
+private:
+
+	// One cache line each, producers writing neighbour slots do not share
+	struct alignas(64) Slot
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::array<Slot, Capacity> slots_;
+	alignas(64) std::atomic<std::size_t> tail_ = 0;
+	alignas(64) std::size_t head_ = 0;
+};
@@ -1,5 +1,109 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <random>
 
-// 64 bits number generator
-inline std::mt19937_64 gen(std::random_device{}());
+// 64 bits number generator, one per thread so boards can be driven concurrently
+inline thread_local std::mt19937_64 gen(std::random_device{}());
+
+// Uniform in [0, bound). The algorithm of std::uniform_int_distribution is up
+// to the standard library, this one gives the same numbers for the same seed
+// everywhere, which replays rely on.
+template <class R>
+std::uint64_t randomBelow(R& rng, std::uint64_t bound)
+{
+	// Rejecting the lowest values leaves a multiple of 'bound' to take the modulo of
+	std::uint64_t threshold = (0 - bound) % bound;
+	std::uint64_t r;
+	do
+		r = rng();
+	while (r < threshold);
+	return r % bound;
+}
+
+inline std::uint64_t randomBelow(std::uint64_t bound)
+{
+	return randomBelow(gen, bound);
+}
+
+// Fresh seed for a new game, independent from 'gen'.
+inline std::uint64_t randomSeed()
+{
+	std::random_device device;
+	return (std::uint64_t(device()) << 32) ^ device();
+}
+
+constexpr std::uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+// SplitMix64 finalizer: spreads consecutive numbers over the whole seed space.
+constexpr std::uint64_t mix(std::uint64_t x)
+{
+	x += GOLDEN_GAMMA;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+// SplitMix64 as a counter based generator: the n-th number of a stream only
+// depends on its key and n. Streams keyed apart can be drawn from by any
+// thread, in any order, and give the same numbers.
+struct CounterRandom
+{
+	using result_type = std::uint64_t;
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~result_type(0); }
+
+	result_type operator()() { return mix(key + counter++ * GOLDEN_GAMMA); }
+
+	std::uint64_t key;
+	std::uint64_t counter = 0;
+};
+
+// How many of 'draws' items taken without replacement out of 'population' are
+// marked, 'marked' items being. Inverts the distribution from its mode, taking
+// the likelier neighbour at each step: a few standard deviations of steps on
+// average. The mode probability goes through lgamma, exact up to rounding.
+template <class R>
+std::uint64_t randomHypergeometric(R& rng, std::uint64_t population, std::uint64_t marked, std::uint64_t draws)
+{
+	std::uint64_t unmarked = population - marked;
+	std::uint64_t low = draws > unmarked ? draws - unmarked : 0;
+	std::uint64_t high = std::min(draws, marked);
+	if (low == high)
+		return low;
+
+	double N = double(population), K = double(marked), n = double(draws);
+	auto logChoose = [](double a, double b) { return std::lgamma(a + 1) - std::lgamma(b + 1) - std::lgamma(a - b + 1); };
+	std::uint64_t mode = std::clamp(std::uint64_t((n + 1) * (K + 1) / (N + 2)), low, high);
+	double pMode = std::exp(logChoose(K, double(mode)) + logChoose(N - K, n - double(mode)) - logChoose(N, n));
+
+	double u = double(rng() >> 11) * 0x1p-53 - pMode;
+	std::uint64_t up = mode, down = mode;
+	double pUp = pMode, pDown = pMode;
+	while (u >= 0 && (up < high || down > low))
+	{
+		double k = double(up);
+		double nextUp = up < high ? pUp * (K - k) * (n - k) / ((k + 1) * (N - K - n + k + 1)) : 0;
+		k = double(down);
+		double nextDown = down > low ? pDown * k * (N - K - n + k) / ((K - k + 1) * (n - k + 1)) : 0;
+		if (nextUp >= nextDown)
+		{
+			pUp = nextUp;
+			u -= pUp;
+			if (u < 0)
+				return up + 1;
+			++up;
+		}
+		else
+		{
+			pDown = nextDown;
+			u -= pDown;
+			if (u < 0)
+				return down - 1;
+			--down;
+		}
+	}
+	// Below the mode probability, or what rounding left unaccounted for
+	return mode;
+}
@@ -0,0 +1,184 @@
+#include "PageArena.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif // _WIN32
+
+namespace
+{
+
+constexpr std::size_t HUGE_PAGE = PageArena::MIN_BLOCK;
+
+// A couple of blocks cover a board and its autosave copy.
+constexpr std::size_t KEPT_BLOCKS = 2;
+// A kept block is not handed out for requests less than half its size.
+constexpr std::size_t MAX_WASTE_RATIO = 2;
+
+struct Block
+{
+	void* address;
+	std::size_t bytes; // rounded up
+};
+
+std::mutex mutex;
+std::array<Block, KEPT_BLOCKS> kept{};
+// Mapped size of every block handed out: a kept block can serve a request
+// smaller than itself, which the caller hands back as its own size.
+std::unordered_map<void*, std::size_t> lent;
+PageArena::Stats stats{};
+
+std::size_t roundUp(std::size_t bytes)
+{
+	return (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+}
+
+#ifdef _WIN32
+
+// Large pages need a privilege users do not have, plain pages it is.
+void* map(std::size_t bytes)
+{
+	return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+// Pages committed again are demand zero: the first access maps a zeroed page.
+void discard(void* address, std::size_t bytes)
+{
+	VirtualFree(address, bytes, MEM_DECOMMIT);
+	VirtualAlloc(address, bytes, MEM_COMMIT, PAGE_READWRITE);
+}
+
+void unmap(void* address, std::size_t)
+{
+	VirtualFree(address, 0, MEM_RELEASE);
+}
+
+#else
+
+void* map(std::size_t bytes)
+{
+	// Over-mapped by a huge page then trimmed, for the block to start on one:
+	// only aligned ranges can be backed by huge pages.
+	std::size_t span = bytes + HUGE_PAGE;
+	void* mapped = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapped == MAP_FAILED)
+		return nullptr;
+
+	auto* start = static_cast<std::byte*>(mapped);
+	std::size_t head = (HUGE_PAGE - std::uintptr_t(start) % HUGE_PAGE) % HUGE_PAGE;
+	if (head)
+		munmap(start, head);
+	if (std::size_t tail = span - head - bytes)
+		munmap(start + head + bytes, tail);
+
+#ifdef MADV_HUGEPAGE
+	madvise(start + head, bytes, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+	return start + head;
+}
+
+void unmap(void* address, std::size_t bytes)
+{
+	munmap(address, bytes);
+}
+
+// Private anonymous pages read back as zeros once dropped.
+void discard(void* address, std::size_t bytes)
+{
+	madvise(address, bytes, MADV_DONTNEED);
+}
+
+#endif // _WIN32
+
+} // namespace
+
+void* PageArena::allocate(std::size_t bytes)
+{
+	bytes = roundUp(bytes);
+	std::lock_guard lock(mutex);
+
+	// The smallest kept block that fits without wasting too much
+	Block* best = nullptr;
+	for (Block& block : kept)
+		if (block.address && block.bytes >= bytes && block.bytes / MAX_WASTE_RATIO <= bytes)
+			if (!best || block.bytes < best->bytes)
+				best = &block;
+
+	if (best)
+	{
+		void* address = best->address;
+		lent.emplace(address, best->bytes);
+		stats.keptBytes -= best->bytes;
+		++stats.recycled;
+		*best = {};
+		return address;
+	}
+
+	void* address = map(bytes);
+	if (!address)
+		throw std::bad_alloc();
+	try
+	{
+		lent.emplace(address, bytes);
+	}
+	catch (...)
+	{
+		unmap(address, bytes);
+		throw;
+	}
+	++stats.mapped;
+	return address;
+}
+
+void PageArena::deallocate(void* address, std::size_t bytes)
+{
+	std::lock_guard lock(mutex);
+	// The size it was mapped with, not the one it was asked for
+	auto it = lent.find(address);
+	assert(it != lent.end() && it->second >= roundUp(bytes));
+	bytes = it->second;
+	lent.erase(it);
+
+	// An empty slot, or else the smallest kept block: it is the cheapest to map again
+	auto slot = std::min_element(kept.begin(), kept.end(), [](const Block& a, const Block& b) { return a.bytes < b.bytes; });
+	if (slot->address)
+	{
+		unmap(slot->address, slot->bytes);
+		stats.keptBytes -= slot->bytes;
+	}
+	*slot = {address, bytes};
+	stats.keptBytes += bytes;
+}
+
+void PageArena::zero(void* block, std::size_t bytes)
+{
+	// Whole pages only: the block is at least as large, rounded up to a huge page
+	constexpr std::size_t PAGE = 4096;
+	discard(block, (bytes + PAGE - 1) / PAGE * PAGE);
+}
+
+void PageArena::trim()
+{
+	std::lock_guard lock(mutex);
+	for (Block& block : kept)
+	{
+		if (block.address)
+			unmap(block.address, block.bytes);
+		block = {};
+	}
+	stats.keptBytes = 0;
+}
+
+PageArena::Stats PageArena::getStats()
+{
+	std::lock_guard lock(mutex);
+	return stats;
+}
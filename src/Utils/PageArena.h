@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/*
+ * Large blocks mapped straight from the OS, for board storage.
+ *
+ * Blocks are aligned on and rounded up to the 2 MiB huge page, and hinted for
+ * transparent huge pages where the system has them: a flood fill over a large
+ * board then misses the TLB once every 2 MiB instead of every 4 KiB, and a
+ * clear faults pages in as many times less often.
+ *
+ * Freed blocks are kept for the next request they fit, rather than unmapped:
+ * their pages stay resident, so the board copies autosave takes, the flood
+ * fill stacks that spill and the boards of consecutive games do not fault
+ * them in again. Only a couple are kept, the smallest making room.
+ */
+namespace PageArena
+{
+
+// Below this, the general purpose allocator does better.
+constexpr std::size_t MIN_BLOCK = std::size_t(2) << 20;
+
+// Throw std::bad_alloc like operator new.
+void* allocate(std::size_t bytes);
+void deallocate(void* block, std::size_t bytes);
+
+// Zeroes the start of a block without writing to it: its pages go back to the
+// OS, and are faulted in again zero filled on first access. Constant time as
+// far as the caller is concerned, the kernel does the work lazily.
+void zero(void* block, std::size_t bytes);
+
+// Unmaps the blocks kept for reuse, once they are unlikely to fit anything:
+// the board was resized.
+void trim();
+
+struct Stats
+{
+	std::uint64_t mapped;   // blocks mapped from the OS
+	std::uint64_t recycled; // requests served by a kept block
+	std::uint64_t keptBytes;
+};
+Stats getStats();
+
+} // namespace PageArena
+
+// Routes the allocations past PageArena::MIN_BLOCK to the arena.
+template <class T>
+struct PageAllocator
+{
+	using value_type = T;
+
+	PageAllocator() = default;
+	template <class U>
+	PageAllocator(const PageAllocator<U>&) {}
+
+	T* allocate(std::size_t n)
+	{
+		std::size_t bytes = n * sizeof(T);
+		if (bytes < PageArena::MIN_BLOCK)
+			return static_cast<T*>(::operator new(bytes));
+		return static_cast<T*>(PageArena::allocate(bytes));
+	}
+
+	void deallocate(T* p, std::size_t n)
+	{
+		std::size_t bytes = n * sizeof(T);
+		if (bytes < PageArena::MIN_BLOCK)
+			::operator delete(p);
+		else
+			PageArena::deallocate(p, bytes);
+	}
+
+	template <class U>
+	bool operator==(const PageAllocator<U>&) const { return true; }
+};
@@ -0,0 +1,33 @@
+#include "SystemMemory.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <limits>
+#include <string>
+#endif // _WIN32
+
+std::optional<std::uint64_t> getAvailableMemory()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX status{.dwLength = sizeof(MEMORYSTATUSEX)};
+	if (GlobalMemoryStatusEx(&status))
+		return status.ullAvailPhys;
+#elif defined(__linux__)
+	// Unlike the free pages sysconf reports, MemAvailable counts the cache the
+	// kernel would drop to make room.
+	std::ifstream meminfo("/proc/meminfo");
+	std::string key;
+	std::uint64_t kiB;
+	while (meminfo >> key >> kiB)
+	{
+		if (key == "MemAvailable:")
+			return kiB * 1024;
+		meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	}
+#endif // _WIN32
+	return std::nullopt;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+
+// Physical memory the system can hand out right now, page cache included.
+// Nullopt if the platform does not tell.
+std::optional<std::uint64_t> getAvailableMemory();
@@ -0,0 +1,178 @@
+#include "Trace.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Event
+{
+	const char* name;
+	const char* argName;
+	std::int64_t arg;
+	std::int64_t start, end;
+};
+
+// Single producer (its thread), single consumer (the writer).
+struct ThreadBuffer
+{
+	static constexpr std::size_t CAPACITY = 1 << 14;
+
+	std::array<Event, CAPACITY> events;
+	std::atomic<std::size_t> head = 0; // next write, producer owned
+	std::atomic<std::size_t> tail = 0; // next read, consumer owned
+	std::atomic<std::uint64_t> dropped = 0;
+	std::uint32_t tid;
+};
+
+constexpr std::chrono::milliseconds FLUSH_PERIOD{50};
+
+struct Tracer
+{
+	std::mutex mutex; // guards everything below, never taken by emit
+	std::condition_variable wake;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	std::FILE* file = nullptr;
+	bool first = true;
+	bool stopping = false;
+	std::jthread writer;
+
+	~Tracer() { Trace::stop(); } // a trace left running is still closed properly
+};
+
+Tracer tracer;
+const auto epoch = std::chrono::steady_clock::now();
+
+// Buffers are never freed, a thread may be about to write in its own
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+ThreadBuffer& getThreadBuffer()
+{
+	if (threadBuffer)
+		return *threadBuffer;
+
+	// Once per thread
+	std::lock_guard lock(tracer.mutex);
+	auto buffer = std::make_unique<ThreadBuffer>();
+	buffer->tid = std::uint32_t(tracer.buffers.size() + 1);
+	threadBuffer = buffer.get();
+	tracer.buffers.push_back(std::move(buffer));
+	return *threadBuffer;
+}
+
+// Writer thread only, or under the mutex once it is gone
+void drain(ThreadBuffer& buffer)
+{
+	std::size_t tail = buffer.tail.load(std::memory_order_relaxed);
+	std::size_t head = buffer.head.load(std::memory_order_acquire);
+	for (; tail != head; ++tail)
+	{
+		const Event& event = buffer.events[tail % ThreadBuffer::CAPACITY];
+		std::fprintf(tracer.file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+		             tracer.first ? "\n" : ",\n", event.name, buffer.tid,
+		             double(event.start) / 1e3, double(event.end - event.start) / 1e3);
+		if (event.argName)
+			std::fprintf(tracer.file, ",\"args\":{\"%s\":%lld}", event.argName, (long long)event.arg);
+		std::fputc('}', tracer.file);
+		tracer.first = false;
+	}
+	buffer.tail.store(tail, std::memory_order_release);
+}
+
+void drainAll()
+{
+	for (auto& buffer : tracer.buffers)
+		drain(*buffer);
+	std::fflush(tracer.file);
+}
+
+void run()
+{
+	std::unique_lock lock(tracer.mutex);
+	while (!tracer.stopping)
+	{
+		tracer.wake.wait_for(lock, FLUSH_PERIOD);
+		drainAll();
+	}
+}
+
+} // namespace
+
+bool Trace::start(const std::filesystem::path& file)
+{
+	stop();
+
+	std::FILE* out = std::fopen(file.string().c_str(), "wb");
+	if (!out)
+		return false;
+
+	std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out);
+	{
+		std::lock_guard lock(tracer.mutex);
+		tracer.file = out;
+		tracer.first = true;
+		tracer.stopping = false;
+
+		// Leftovers of a previous trace are skipped
+		for (auto& buffer : tracer.buffers)
+		{
+			buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+			buffer->dropped.store(0, std::memory_order_relaxed);
+		}
+	}
+	tracer.writer = std::jthread(run);
+	enabled.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+void Trace::stop()
+{
+	if (!tracer.writer.joinable())
+		return;
+
+	enabled.store(false, std::memory_order_relaxed);
+	{
+		std::lock_guard lock(tracer.mutex);
+		tracer.stopping = true;
+	}
+	tracer.wake.notify_one();
+	tracer.writer.join();
+
+	// Scopes still open on other threads may emit a little longer, they are lost
+	std::lock_guard lock(tracer.mutex);
+	drainAll();
+	std::uint64_t dropped = 0;
+	for (auto& buffer : tracer.buffers)
+		dropped += buffer->dropped.load(std::memory_order_relaxed);
+	std::fprintf(tracer.file, "\n],\"otherData\":{\"droppedEvents\":%llu}}\n", (unsigned long long)dropped);
+	std::fclose(tracer.file);
+	tracer.file = nullptr;
+}
+
+std::int64_t Trace::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::emit(const char* name, std::int64_t start, std::int64_t end, const char* argName, std::int64_t arg)
+{
+	if (!isEnabled())
+		return;
+
+	ThreadBuffer& buffer = getThreadBuffer();
+	std::size_t head = buffer.head.load(std::memory_order_relaxed);
+	if (head - buffer.tail.load(std::memory_order_acquire) == ThreadBuffer::CAPACITY)
+	{
+		buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer.events[head % ThreadBuffer::CAPACITY] = {name, argName, arg, start, end};
+	buffer.head.store(head + 1, std::memory_order_release);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+/*
+ * Scoped timers written as Chrome trace events, to open in ui.perfetto.dev or
+ * chrome://tracing.
+ *
+ * Each thread appends its events to its own ring buffer, without any lock, and
+ * a background thread drains them all to the file. When a buffer is full, the
+ * events are dropped and counted rather than waited on. While tracing is off,
+ * a scope costs a relaxed load and a branch.
+ */
+namespace Trace
+{
+
+// False if the file cannot be created. Tracing stays off then.
+bool start(const std::filesystem::path& file);
+// Drains every buffer and closes the file.
+void stop();
+
+inline std::atomic<bool> enabled = false;
+inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+std::int64_t now(); // ns
+
+// 'name' and 'argName' must outlive the trace: string literals.
+void emit(const char* name, std::int64_t start, std::int64_t end, const char* argName, std::int64_t arg);
+
+class Scope
+{
+public:
+
+	explicit Scope(const char* name, const char* argName = nullptr, std::int64_t arg = 0)
+		: name_(isEnabled() ? name : nullptr)
+		, argName_(argName)
+		, arg_(arg)
+		, start_(name_ ? now() : 0)
+	{}
+
+	~Scope()
+	{
+		if (name_)
+			emit(name_, start_, now(), argName_, arg_);
+	}
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+
+	const char* name_;
+	const char* argName_;
+	std::int64_t arg_;
+	std::int64_t start_;
+};
+
+} // namespace Trace
+
+#define MPP_TRACE_CONCAT_IMPL(a, b) a##b
+#define MPP_TRACE_CONCAT(a, b) MPP_TRACE_CONCAT_IMPL(a, b)
+
+// Traces the rest of the enclosing block: MPP_TRACE_SCOPE("name"[, "argName", arg]).
+#define MPP_TRACE_SCOPE(...) Trace::Scope MPP_TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
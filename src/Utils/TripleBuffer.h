@@ -0,0 +1,58 @@
+#pragma once
+#include "NotCopyable.h"
+#include "NotMovable.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Hands the latest value over from one writer thread to one reader thread,
+ * lock-free, neither of them ever waiting on the other.
+ *
+ * Three slots: the writer fills the back one, the reader holds the front one,
+ * and the middle one is the last published. Publishing swaps back and middle,
+ * acquiring swaps middle and front, each with a single exchange. A value the
+ * reader did not get to in time is overwritten by the next one: only the
+ * latest counts.
+ */
+template <class T>
+class TripleBuffer : NotCopyable, NotMovable
+{
+public:
+
+	// Writer thread only. Slots keep what was last written to them, the writer
+	// tells them apart by index.
+	T& back() { return slots_[back_]; }
+	std::size_t getBackIndex() const { return back_; }
+	void publish()
+	{
+		back_ = middle_.exchange(std::uint8_t(back_ | FRESH), std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader thread only. Returns false if nothing was published since the last
+	// call, the front is then left as is.
+	bool acquire()
+	{
+		if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+			return false;
+		front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	const T& front() const { return slots_[front_]; }
+
+	// Any thread, a hint: the reader may be acquiring it at the same time.
+	bool hasFresh() const { return middle_.load(std::memory_order_relaxed) & FRESH; }
+
+	static constexpr std::size_t SLOT_COUNT = 3;
+
+private:
+
+	static constexpr std::uint8_t INDEX = 3;
+	static constexpr std::uint8_t FRESH = 4;
+
+	std::array<T, SLOT_COUNT> slots_;
+	alignas(64) std::uint8_t back_ = 0;
+	alignas(64) std::atomic<std::uint8_t> middle_ = 1;
+	alignas(64) std::uint8_t front_ = 2;
+};
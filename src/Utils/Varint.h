@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// LEB128: 7 bits per byte, the top bit tells that more bytes follow.
+namespace Varint
+{
+
+inline void write(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(std::uint8_t(value) | 0x80);
+		value >>= 7;
+	}
+	out.push_back(std::uint8_t(value));
+}
+
+// Moves 'pos' past the value. Returns false if the bytes end before it does.
+template <class Byte>
+bool read(std::span<const Byte> in, std::size_t& pos, std::uint64_t& value)
+{
+	value = 0;
+	for (unsigned shift = 0; pos < in.size() && shift < 64; shift += 7)
+	{
+		auto byte = std::uint8_t(in[pos++]);
+		value |= std::uint64_t(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+} // namespace Varint
@@ -0,0 +1,354 @@
+#include "Game/Board.h"
+#include "Game/BoardEncoder.h"
+#include "Utils/JobSystem.h"
+#include "Utils/MyRandom.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+/*
+ * Micro-benchmarks of the board operations over a matrix of sizes and mine
+ * densities, printed as JSON so that runs can be compared over time.
+ * Every case is seeded, two runs with the same seed time the same work.
+ * Parallel mine placement is also timed over thread counts, on a board large
+ * enough to be placed in parallel, checking that the layout never changes.
+ * Usage: MineBench [seed] [target time per case in ms]
+ */
+
+namespace
+{
+
+constexpr Vec2s SIZES[] = {{30, 16}, {256, 256}, {2048, 2048}};
+constexpr double DENSITIES[] = {0.10, 0.15, 0.21};
+
+constexpr std::size_t MIN_SAMPLES = 5;
+constexpr std::size_t MAX_CALLS = 256; // per sample, for the cheap operations
+constexpr std::size_t ENCODE_CHUNK = 512; // as the renderer does
+
+constexpr Vec2s PLACEMENT_SIZE = {4096, 4096};
+constexpr double PLACEMENT_DENSITY = 0.15;
+constexpr unsigned PLACEMENT_THREADS[] = {1, 2, 4, 8, 16, 32};
+constexpr std::size_t PLACEMENT_SAMPLES = 3;
+
+using Clock = std::chrono::steady_clock;
+
+// One timed run of an operation, on a freshly prepared board.
+struct Sample
+{
+	std::chrono::nanoseconds time;
+	std::size_t calls;
+	std::size_t cells; // touched by the calls, 0 if not meaningful
+};
+
+bool parse(const char* arg, auto& value)
+{
+	std::string_view str(arg);
+	auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	return ec == std::errc{} && end == str.data() + str.size();
+}
+
+void reset(Board& board)
+{
+	board.clear();
+	board.placeMines();
+}
+
+// Up to MAX_CALLS indexes matching 'predicate', spread over the whole board.
+template <class P>
+std::vector<std::size_t> pick(const Board& board, P&& predicate)
+{
+	std::vector<std::size_t> all;
+	for (std::size_t i = 0; i < board.getCells().size(); ++i)
+		if (predicate(board.getCellAt(i)))
+			all.push_back(i);
+
+	std::vector<std::size_t> picked;
+	std::size_t step = std::max<std::size_t>(all.size() / MAX_CALLS, 1);
+	for (std::size_t i = 0; i < all.size() && picked.size() < MAX_CALLS; i += step)
+		picked.push_back(all[i]);
+	return picked;
+}
+
+bool isMined(const Cell& cell) { return cell.mined; }
+bool isNumbered(const Cell& cell) { return !cell.mined && cell.adjacentMines; }
+bool isEmpty(const Cell& cell) { return !cell.mined && !cell.adjacentMines; }
+
+template <class F>
+Sample time(std::size_t calls, F&& f)
+{
+	auto start = Clock::now();
+	std::size_t cells = f();
+	return {Clock::now() - start, calls, cells};
+}
+
+// Each returns false when the board does not allow the operation (no empty cell to cascade from).
+using Case = bool(*)(Board& board, Sample& sample);
+
+bool placeMines(Board& board, Sample& sample)
+{
+	board.clear();
+	sample = time(1, [&] { board.placeMines(); return board.getCells().size(); });
+	return true;
+}
+
+bool makeSafe(Board& board, Sample& sample)
+{
+	reset(board);
+	auto indexes = pick(board, isMined);
+	sample = time(indexes.size(), [&]
+	{
+		for (std::size_t index : indexes)
+			board.makeSafe(index);
+		return std::size_t(0);
+	});
+	return !indexes.empty();
+}
+
+bool openSingle(Board& board, Sample& sample)
+{
+	reset(board);
+	auto indexes = pick(board, isNumbered);
+	sample = time(indexes.size(), [&]
+	{
+		for (std::size_t index : indexes)
+			board.open(index);
+		return board.getOpenCount();
+	});
+	return !indexes.empty();
+}
+
+bool openCascade(Board& board, Sample& sample)
+{
+	reset(board);
+	// A random empty cell, not always the first one of the board
+	std::size_t cellCount = board.getCells().size();
+	std::size_t start = randomBelow(cellCount);
+	for (std::size_t i = 0; i < cellCount; ++i)
+	{
+		std::size_t index = (start + i) % cellCount;
+		if (isEmpty(board.getCellAt(index)))
+		{
+			sample = time(1, [&] { board.open(index); return board.getOpenCount(); });
+			return true;
+		}
+	}
+	return false;
+}
+
+bool chord(Board& board, Sample& sample)
+{
+	reset(board);
+	auto indexes = pick(board, isNumbered);
+	for (std::size_t index : indexes)
+	{
+		board.open(index);
+		for (auto& coordinates : board.getNeighboursOf(board.toCoordinates(index)))
+		{
+			std::size_t neighbour = board.toIndex(coordinates);
+			if (board.getCellAt(neighbour).mined && !board.getCellAt(neighbour).flagged)
+				board.flag(neighbour);
+		}
+	}
+
+	std::size_t opened = board.getOpenCount();
+	sample = time(indexes.size(), [&]
+	{
+		for (std::size_t index : indexes)
+			board.open(index);
+		return board.getOpenCount() - opened;
+	});
+	return !indexes.empty();
+}
+
+bool moveMine(Board& board, Sample& sample)
+{
+	reset(board);
+	auto indexes = pick(board, isMined);
+	sample = time(indexes.size(), [&]
+	{
+		for (std::size_t index : indexes)
+			board.moveMine(index);
+		return std::size_t(0);
+	});
+	return !indexes.empty();
+}
+
+bool encode(Board& board, Sample& sample)
+{
+	// A game in progress: a first cascade from the center
+	reset(board);
+	Vec2s size = board.getSize();
+	std::size_t center = board.toIndex({size.x / 2, size.y / 2});
+	board.makeSafe(center);
+	board.open(center);
+
+	static const std::vector<std::size_t> noRunningMines;
+	BoardEncoder::State state{.reveal = BoardEncoder::Reveal::None, .pressedCellIndex = center, .runningMineIndexes = noRunningMines};
+	std::array<std::uint8_t, ENCODE_CHUNK> chunk;
+	std::size_t cellCount = board.getCells().size();
+	volatile std::uint8_t sink = 0;
+
+	sample = time(1, [&]
+	{
+		for (std::size_t first = 0; first < cellCount; first += chunk.size())
+		{
+			std::size_t count = std::min(chunk.size(), cellCount - first);
+			BoardEncoder::encode(board, state, first, {chunk.data(), count});
+			sink = sink + chunk[0];
+		}
+		return cellCount;
+	});
+	return true;
+}
+
+struct Op
+{
+	std::string_view name;
+	Case run;
+};
+
+constexpr Op OPS[] =
+{
+	{"placeMines", placeMines},
+	{"makeSafe", makeSafe},
+	{"open.single", openSingle},
+	{"open.cascade", openCascade},
+	{"open.chord", chord},
+	{"moveMine", moveMine},
+	{"encode", encode},
+};
+
+double median(std::vector<double>& values)
+{
+	auto middle = values.begin() + std::ptrdiff_t(values.size() / 2);
+	std::nth_element(values.begin(), middle, values.end());
+	return *middle;
+}
+
+std::uint64_t hashLayout(const Board& board)
+{
+	std::uint64_t hash = 0;
+	for (const Cell& cell : board.getCells())
+		hash = mix(hash ^ (std::uint64_t(cell.mined) << 4 | cell.adjacentMines));
+	return hash;
+}
+
+// Median milliseconds per placement at each thread count, false if a layout
+// differs from the single threaded one.
+bool placementScaling(std::uint64_t seed)
+{
+	Board board;
+	board.resize(PLACEMENT_SIZE);
+	board.setMineCount(std::size_t(double(PLACEMENT_SIZE.x * PLACEMENT_SIZE.y) * PLACEMENT_DENSITY + 0.5));
+
+	std::printf(",\n  \"placementScaling\": {\"width\": %zu, \"height\": %zu, \"mines\": %zu, \"results\": [",
+	            PLACEMENT_SIZE.x, PLACEMENT_SIZE.y, board.getMineCount());
+	const char* separator = "\n";
+	std::uint64_t reference = 0;
+	bool same = true;
+	std::vector<double> times;
+	for (unsigned threads : PLACEMENT_THREADS)
+	{
+		JobSystem jobs(threads);
+		times.clear();
+		for (std::size_t s = 0; s < PLACEMENT_SAMPLES; ++s)
+		{
+			board.clear();
+			auto start = Clock::now();
+			board.placeMinesParallel(seed, &jobs);
+			times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		std::uint64_t hash = hashLayout(board);
+		if (threads == PLACEMENT_THREADS[0])
+			reference = hash;
+		same &= hash == reference;
+
+		double ms = median(times);
+		std::printf("%s    {\"threads\": %u, \"ms\": %.2f, \"sameLayout\": %s}",
+		            separator, threads, ms, hash == reference ? "true" : "false");
+		std::fflush(stdout);
+		separator = ",\n";
+	}
+	std::printf("\n  ]}");
+	return same;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::uint64_t seed = 0;
+	unsigned targetMs = 50;
+	if (argc > 3 || (argc > 1 && !parse(argv[1], seed)) || (argc > 2 && !parse(argv[2], targetMs)))
+	{
+		std::fprintf(stderr, "Usage: %s [seed] [target time per case in ms]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Samples are taken until 'target' is spent timing them, or ten times that
+	// preparing boards, whichever comes first
+	std::chrono::nanoseconds target = std::chrono::milliseconds(targetMs);
+
+	std::printf("{\n  \"seed\": %ju,\n  \"targetMs\": %u,\n  \"results\": [", std::uintmax_t(seed), targetMs);
+	const char* separator = "\n";
+
+	Board board;
+	std::vector<double> perCall, perCell;
+	for (const Vec2s& size : SIZES)
+	{
+		for (double density : DENSITIES)
+		{
+			std::size_t mines = std::size_t(double(size.x * size.y) * density + 0.5);
+			board.resize(size);
+			board.setMineCount(mines);
+
+			for (const Op& op : OPS)
+			{
+				gen.seed(seed);
+				perCall.clear();
+				perCell.clear();
+				std::chrono::nanoseconds measured{0};
+				std::size_t calls = 0;
+
+				auto start = Clock::now();
+				Sample sample;
+				while (perCall.size() < MIN_SAMPLES || (measured < target && Clock::now() - start < target * 10))
+				{
+					if (!op.run(board, sample) || sample.calls == 0)
+						break;
+
+					measured += sample.time;
+					calls += sample.calls;
+					perCall.push_back(double(sample.time.count()) / double(sample.calls));
+					if (sample.cells)
+						perCell.push_back(double(sample.time.count()) / double(sample.cells));
+				}
+
+				if (perCall.empty())
+					continue; // nothing to measure on this board
+
+				double minPerCall = *std::min_element(perCall.begin(), perCall.end());
+				std::printf("%s    {\"op\": \"%.*s\", \"width\": %zu, \"height\": %zu, \"mines\": %zu, \"density\": %.2f, "
+				            "\"samples\": %zu, \"calls\": %zu, \"nsPerCall\": {\"min\": %.1f, \"median\": %.1f}",
+				            separator, int(op.name.size()), op.name.data(), size.x, size.y, mines, density,
+				            perCall.size(), calls, minPerCall, median(perCall));
+				if (!perCell.empty())
+					std::printf(", \"nsPerCell\": %.3f", median(perCell));
+				std::printf("}");
+				std::fflush(stdout);
+				separator = ",\n";
+			}
+		}
+	}
+
+	std::printf("\n  ]");
+	bool same = placementScaling(seed);
+	std::printf("\n}\n");
+	return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
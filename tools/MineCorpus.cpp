@@ -0,0 +1,280 @@
+#include "Sim/BoardCorpus.h"
+#include "Utils/MyRandom.h"
+#include "Utils/PageArena.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+/*
+ * Writes the flood fill corpus, or measures Board::open over it: every entry is
+ * opened from its start cell, the cascade covering as much of the board as its
+ * layout lets it.
+ * Large boards, too big for the file, are laid out on the spot: their rounds
+ * time the allocation of the board and its flood fill stack, then the fill.
+ * The frontier mode opens most of a large board with few mines, then finds its
+ * frontier by walking the one the Board tracked, and by scanning every cell.
+ * Every mine is then flagged, and chordAll opens what is left, called again
+ * while a pass opens cells behind it.
+ * Usage: MineCorpus generate [file] [seed]
+ *        MineCorpus bench [file]
+ *        MineCorpus large [side]
+ *        MineCorpus frontier [side]
+ */
+
+namespace
+{
+
+constexpr Vec2s SIZES[] = {{64, 64}, {1024, 1024}, {4096, 512}};
+
+constexpr std::size_t DEFAULT_LARGE_SIDE = 8192;
+constexpr int LARGE_ROUNDS = 3;
+constexpr std::size_t FRONTIER_CELLS_PER_MINE = 1000; // sparse enough for one cascade to open most of it
+
+constexpr int MIN_RUNS = 3;
+constexpr std::chrono::milliseconds BENCH_TIME{200}; // per entry
+
+bool parse(const char* arg, auto& value)
+{
+	std::string_view str(arg);
+	auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	return ec == std::errc{} && end == str.data() + str.size();
+}
+
+int generate(const std::filesystem::path& file, std::uint64_t seed)
+{
+	gen.seed(seed);
+	std::vector<BoardCorpus::Entry> entries;
+	for (const Vec2s& size : SIZES)
+	{
+		for (std::size_t l = 0; l < std::size_t(BoardCorpus::Layout::Count); ++l)
+		{
+			BoardCorpus::Entry entry;
+			if (BoardCorpus::generate(BoardCorpus::Layout(l), size, entry))
+				entries.push_back(std::move(entry));
+			else
+				std::fprintf(stderr, "%s %zux%zu: cannot be generated\n",
+				             BoardCorpus::getName(BoardCorpus::Layout(l)).data(), size.x, size.y);
+		}
+	}
+
+	if (!BoardCorpus::save(file, entries))
+	{
+		std::fprintf(stderr, "Cannot write %s\n", file.string().c_str());
+		return EXIT_FAILURE;
+	}
+	std::printf("%zu boards written to %s (%ju bytes)\n", entries.size(), file.string().c_str(), std::uintmax_t(std::filesystem::file_size(file)));
+	return EXIT_SUCCESS;
+}
+
+int bench(const std::filesystem::path& file)
+{
+	std::vector<BoardCorpus::Entry> entries;
+	if (!BoardCorpus::load(file, entries))
+	{
+		std::fprintf(stderr, "%s: not a corpus\n", file.string().c_str());
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%-10s %11s %10s %9s %7s %6s %8s %11s %11s\n",
+	            "layout", "size", "opened", "Mcells/s", "peak", "spill", "push/c", "board KB", "stack KB");
+
+	Board board;
+	for (const BoardCorpus::Entry& entry : entries)
+	{
+		// Best of a few runs, a fresh board each time
+		double best = 1e300;
+		Board::Counters counters{};
+		auto benchStart = std::chrono::steady_clock::now();
+		for (int run = 0; run < MIN_RUNS || std::chrono::steady_clock::now() - benchStart < BENCH_TIME; ++run)
+		{
+			if (!BoardCorpus::makeBoard(entry, board))
+			{
+				std::fprintf(stderr, "%s %zux%zu: invalid board\n",
+				             BoardCorpus::getName(entry.layout).data(), entry.size.x, entry.size.y);
+				return EXIT_FAILURE;
+			}
+			board.resetCounters();
+
+			auto start = std::chrono::steady_clock::now();
+			board.open(entry.start);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+			counters = board.getCounters();
+		}
+
+		// The stack only takes heap memory once it spills, the board is always there
+		std::size_t boardBytes = board.getCells().size() * sizeof(Cell);
+		std::size_t stackBytes = std::size_t(counters.seedStackPeak) * sizeof(std::size_t);
+		std::printf("%-10s %5zux%-5zu %10ju %9.1f %7ju %6ju %8.3f %11.1f %11.1f\n",
+		            BoardCorpus::getName(entry.layout).data(), entry.size.x, entry.size.y,
+		            std::uintmax_t(counters.cellsOpened),
+		            double(counters.cellsOpened) / best / 1e6,
+		            std::uintmax_t(counters.seedStackPeak),
+		            std::uintmax_t(counters.seedStackSpills),
+		            counters.cellsOpened ? double(counters.scanRowPushes) / double(counters.cellsOpened) : 0.0,
+		            double(boardBytes) / 1e3,
+		            double(stackBytes) / 1e3);
+	}
+	return EXIT_SUCCESS;
+}
+
+// The first round maps fresh pages, the next ones reuse what the arena kept.
+int large(std::size_t side)
+{
+	using Clock = std::chrono::steady_clock;
+	auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+	std::printf("%-10s %11s %5s %10s %10s %9s %7s %9s\n",
+	            "layout", "size", "round", "setup ms", "fill ms", "Mcells/s", "mapped", "recycled");
+
+	for (BoardCorpus::Layout layout : {BoardCorpus::Layout::Empty, BoardCorpus::Layout::Lattice})
+	{
+		BoardCorpus::Entry entry;
+		if (!BoardCorpus::generate(layout, {side, side}, entry))
+		{
+			std::fprintf(stderr, "%s %zux%zu: cannot be generated\n", BoardCorpus::getName(layout).data(), side, side);
+			return EXIT_FAILURE;
+		}
+
+		PageArena::trim();
+		for (int round = 0; round < LARGE_ROUNDS; ++round)
+		{
+			PageArena::Stats before = PageArena::getStats();
+			auto start = Clock::now();
+			Board board;
+			if (!BoardCorpus::makeBoard(entry, board))
+				return EXIT_FAILURE;
+			auto fillStart = Clock::now();
+			board.open(entry.start);
+			auto end = Clock::now();
+			PageArena::Stats after = PageArena::getStats();
+
+			std::printf("%-10s %5zux%-5zu %5d %10.1f %10.1f %9.1f %7ju %9ju\n",
+			            BoardCorpus::getName(layout).data(), side, side, round,
+			            ms(fillStart - start), ms(end - fillStart),
+			            double(board.getOpenCount()) / ms(end - fillStart) / 1e3,
+			            std::uintmax_t(after.mapped - before.mapped),
+			            std::uintmax_t(after.recycled - before.recycled));
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+// The whole board cascades from one cell, but for the mines and the numbers
+// around them: the frontier is a small part of it.
+int frontier(std::size_t side)
+{
+	using Clock = std::chrono::steady_clock;
+	auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+	Board board;
+	board.resize({side, side});
+	board.setMineCount(side * side / FRONTIER_CELLS_PER_MINE);
+	gen.seed(0);
+	board.placeMines();
+
+	const Board::Cells& cells = board.getCells();
+	auto start = std::find_if(cells.begin(), cells.end(), [](const Cell& cell) { return !cell.mined && !cell.adjacentMines; });
+	if (start == cells.end())
+	{
+		std::fprintf(stderr, "%zux%zu: no cell to start from\n", side, side);
+		return EXIT_FAILURE;
+	}
+	std::size_t startIndex = std::size_t(start - cells.begin());
+
+	Board tracked = board;
+	tracked.setFrontierTracked(true);
+
+	auto openStart = Clock::now();
+	board.open(startIndex);
+	auto trackedStart = Clock::now();
+	tracked.open(startIndex);
+	auto trackedEnd = Clock::now();
+
+	// What an analysis without the index does: look at every cell
+	std::size_t scanned = 0;
+	auto scanStart = Clock::now();
+	for (std::size_t i = 0; i < cells.size(); ++i)
+	{
+		const Cell& cell = cells[i];
+		if (!cell.opened || cell.mined || !cell.adjacentMines)
+			continue;
+		for (const Vec2s& coordinates : board.getNeighboursOf(board.toCoordinates(i)))
+		{
+			const Cell& neighbour = board.getCellAt(board.toIndex(coordinates));
+			if (!neighbour.opened && !neighbour.flagged)
+			{
+				++scanned;
+				break;
+			}
+		}
+	}
+	auto walkStart = Clock::now();
+	std::size_t walked = 0;
+	tracked.forEachFrontierCell([&](std::size_t) { ++walked; });
+	auto walkEnd = Clock::now();
+
+	if (walked != scanned || walked != tracked.getFrontierSize())
+	{
+		std::fprintf(stderr, "%zux%zu: frontier of %zu cells walked, %zu scanned\n", side, side, walked, scanned);
+		return EXIT_FAILURE;
+	}
+
+	std::size_t opened = tracked.getOpenCount();
+	for (std::size_t i = 0; i < cells.size(); ++i)
+	{
+		if (cells[i].mined)
+			tracked.flag(i);
+	}
+	int passes = 0;
+	auto chordStart = Clock::now();
+	for (std::size_t before = 0; before != tracked.getOpenCount(); ++passes)
+	{
+		before = tracked.getOpenCount();
+		tracked.chordAll();
+	}
+	auto chordEnd = Clock::now();
+	if (!tracked.isWon())
+	{
+		std::fprintf(stderr, "%zux%zu: chordAll left %zu cells closed\n", side, side, cells.size() - tracked.getMineCount() - tracked.getOpenCount());
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%11s %9s %10s %9s %9s %12s %9s %9s %9s %6s %10s\n",
+	            "size", "mines", "opened", "frontier", "open ms", "tracked ms", "scan ms", "walk ms", "chorded", "passes", "chord ms");
+	std::printf("%5zux%-5zu %9zu %10zu %9zu %9.1f %12.1f %9.2f %9.3f %9zu %6d %10.1f\n",
+	            side, side, board.getMineCount(), opened, walked,
+	            ms(trackedStart - openStart), ms(trackedEnd - trackedStart),
+	            ms(walkStart - scanStart), ms(walkEnd - walkStart),
+	            tracked.getOpenCount() - opened, passes, ms(chordEnd - chordStart));
+	return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::string_view mode = argc > 1 ? argv[1] : "";
+	std::filesystem::path file = argc > 2 ? argv[2] : BoardCorpus::DEFAULT_PATH;
+
+	std::uint64_t seed = 0;
+	if (mode == "generate" && argc <= 4 && (argc < 4 || parse(argv[3], seed)))
+		return generate(file, seed);
+	if (mode == "bench" && argc <= 3)
+		return bench(file);
+
+	std::size_t side = DEFAULT_LARGE_SIDE;
+	if (mode == "large" && argc <= 3 && (argc < 3 || parse(argv[2], side)))
+		return large(side);
+	if (mode == "frontier" && argc <= 3 && (argc < 3 || parse(argv[2], side)))
+		return frontier(side);
+
+	std::fprintf(stderr, "Usage: %s generate [file] [seed]\n       %s bench [file]\n       %s large [side]\n       %s frontier [side]\n",
+	             argv[0], argv[0], argv[0], argv[0]);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,524 @@
+#include "Game/Board.h"
+#include "Utils/MyRandom.h"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/*
+ * Differential fuzzing of the Board against a reference model: a plain grid,
+ * opened by a breadth first search over every neighbour. Both play the same
+ * board and actions, and must agree on every cell, the open and flag counts,
+ * whether each open hit a mine, and on the frontier the Board keeps track of.
+ *
+ * An input is a board size, a mine count, a seed for the mine placement, then
+ * actions: open (or chord), flag, makeSafe, moveMine and chordAll. The random
+ * moves of makeSafe and moveMine are made by the Board, then checked and
+ * replayed on the model.
+ *
+ * Built with MPP_LIBFUZZER, this is a libFuzzer target. Otherwise it fuzzes
+ * with random inputs, then replays them on each implementation alone to
+ * compare their throughput.
+ * Usage: MineFuzz [inputs] [seed]
+ *        MineFuzz <input file>...
+ */
+
+namespace
+{
+
+constexpr std::size_t MAX_SIDE = 48;
+constexpr std::size_t MAX_INPUT_SIZE = 1024; // random inputs
+constexpr std::size_t DEFAULT_INPUTS = 100000;
+
+enum class Op : std::uint8_t
+{
+	Open,
+	Flag,
+	MakeSafe,
+	MoveMine,
+	ChordAll
+};
+constexpr std::uint64_t OP_COUNT = 5;
+
+struct Action
+{
+	Op op;
+	std::size_t index;
+	std::size_t destination; // of the mine, filled by the Board for moves
+};
+
+// Everything the implementations play, once the Board resolved the random parts
+struct Trace
+{
+	Vec2s size;
+	std::vector<std::uint64_t> mined; // after placeMines
+	std::vector<Action> actions;
+};
+
+// Reads the input front to back, zeros once it runs out
+class Reader
+{
+public:
+
+	explicit Reader(std::span<const std::uint8_t> bytes) : bytes_(bytes), pos_(0) {}
+
+	bool done() const { return pos_ >= bytes_.size(); }
+
+	std::uint64_t read(std::size_t count)
+	{
+		std::uint64_t value = 0;
+		for (std::size_t i = 0; i < count; ++i)
+			value |= std::uint64_t(pos_ < bytes_.size() ? bytes_[pos_++] : 0) << (8 * i);
+		return value;
+	}
+
+private:
+
+	std::span<const std::uint8_t> bytes_;
+	std::size_t pos_;
+};
+
+class Reference
+{
+public:
+
+	void reset(const Vec2s& size, std::span<const std::uint64_t> mined)
+	{
+		size_ = size;
+		std::size_t cellCount = size.x * size.y;
+		mined_.assign(cellCount, 0);
+		opened_.assign(cellCount, 0);
+		flagged_.assign(cellCount, 0);
+		for (std::size_t i = 0; i < cellCount; ++i)
+			mined_[i] = (mined[i / 64] >> (i % 64)) & 1;
+		openCount_ = flagCount_ = 0;
+	}
+
+	bool open(std::size_t index)
+	{
+		if (flagged_[index])
+			return false;
+
+		if (!opened_[index])
+			return reveal(index);
+
+		// Chording
+		std::size_t flags = 0;
+		forEachNeighbour(index, [&](std::size_t n) { flags += flagged_[n]; });
+		if (flags != adjacentMines(index))
+			return false;
+
+		bool mineOpened = false;
+		forEachNeighbour(index, [&](std::size_t n)
+		{
+			if (!opened_[n] && !flagged_[n])
+				mineOpened |= reveal(n);
+		});
+		return mineOpened;
+	}
+
+	// Every number satisfied once reached, in index order
+	bool chordAll()
+	{
+		bool mineOpened = false;
+		for (std::size_t i = 0; i < opened_.size(); ++i)
+		{
+			if (isFrontier(i) && flagsAround(i) == adjacentMines(i))
+				mineOpened |= open(i);
+		}
+		return mineOpened;
+	}
+
+	void flag(std::size_t index)
+	{
+		if (opened_[index])
+			return;
+		flagged_[index] ^= 1;
+		flagCount_ += flagged_[index] ? 1 : std::size_t(-1);
+	}
+
+	void relocateMine(std::size_t from, std::size_t to)
+	{
+		mined_[from] = 0;
+		mined_[to] = 1;
+	}
+
+	bool isMined(std::size_t index) const { return mined_[index]; }
+	bool isOpened(std::size_t index) const { return opened_[index]; }
+	bool isFlagged(std::size_t index) const { return flagged_[index]; }
+	std::size_t getOpenCount() const { return openCount_; }
+	std::size_t getFlagCount() const { return flagCount_; }
+
+	// Opened, showing a number, and a closed unflagged neighbour left
+	bool isFrontier(std::size_t index) const
+	{
+		if (!opened_[index] || mined_[index] || !adjacentMines(index))
+			return false;
+		bool closed = false;
+		forEachNeighbour(index, [&](std::size_t n) { closed |= !opened_[n] && !flagged_[n]; });
+		return closed;
+	}
+
+	std::size_t flagsAround(std::size_t index) const
+	{
+		std::size_t count = 0;
+		forEachNeighbour(index, [&](std::size_t n) { count += flagged_[n]; });
+		return count;
+	}
+
+	// The cell counts itself, as in the Board: a mine never shows zero
+	std::size_t adjacentMines(std::size_t index) const
+	{
+		std::size_t count = mined_[index];
+		forEachNeighbour(index, [&](std::size_t n) { count += mined_[n]; });
+		return count;
+	}
+
+	template <class F>
+	void forEachNeighbour(std::size_t index, F&& f) const
+	{
+		std::size_t x = index % size_.x, y = index / size_.x;
+		for (std::size_t ny = y ? y - 1 : 0; ny <= y + 1 && ny < size_.y; ++ny)
+			for (std::size_t nx = x ? x - 1 : 0; nx <= x + 1 && nx < size_.x; ++nx)
+				if (nx != x || ny != y)
+					f(ny * size_.x + nx);
+	}
+
+private:
+
+	// Opens the cell, and the whole area around it if it has no mine around
+	bool reveal(std::size_t index)
+	{
+		uncover(index);
+		if (mined_[index])
+			return true;
+
+		std::deque<std::size_t> queue = {index};
+		while (!queue.empty())
+		{
+			std::size_t cell = queue.front();
+			queue.pop_front();
+			if (adjacentMines(cell))
+				continue;
+
+			forEachNeighbour(cell, [&](std::size_t n)
+			{
+				if (!opened_[n])
+				{
+					uncover(n);
+					queue.push_back(n);
+				}
+			});
+		}
+		return false;
+	}
+
+	void uncover(std::size_t index)
+	{
+		// A cascade takes flags away
+		flagCount_ -= flagged_[index];
+		flagged_[index] = 0;
+		opened_[index] = 1;
+		++openCount_;
+	}
+
+	Vec2s size_{};
+	std::vector<std::uint8_t> mined_, opened_, flagged_;
+	std::size_t openCount_ = 0, flagCount_ = 0;
+};
+
+void fail(const char* what, std::size_t step, std::size_t index)
+{
+	std::fprintf(stderr, "Mismatch after action %zu (cell %zu): %s\n", step, index, what);
+	std::abort();
+}
+
+void compare(const Board& board, const Reference& reference, std::size_t step)
+{
+	const auto& cells = board.getCells();
+	for (std::size_t i = 0; i < cells.size(); ++i)
+	{
+		const Cell& cell = cells[i];
+		if (cell.mined != reference.isMined(i))
+			fail("mined", step, i);
+		if (cell.opened != reference.isOpened(i))
+			fail("opened", step, i);
+		if (cell.flagged != reference.isFlagged(i))
+			fail("flagged", step, i);
+		if (cell.adjacentMines != reference.adjacentMines(i))
+			fail("adjacent mines", step, i);
+		if (board.getFlagsAround(i) != reference.flagsAround(i))
+			fail("flags around", step, i);
+	}
+	if (board.getOpenCount() != reference.getOpenCount())
+		fail("open count", step, 0);
+	if (board.getFlagCount() != reference.getFlagCount())
+		fail("flag count", step, 0);
+
+	std::size_t frontierSize = 0;
+	for (std::size_t i = 0; i < cells.size(); ++i)
+		frontierSize += reference.isFrontier(i);
+	if (board.getFrontierSize() != frontierSize)
+		fail("frontier size", step, 0);
+
+	std::size_t walked = 0;
+	board.forEachFrontierCell([&](std::size_t i)
+	{
+		if (!reference.isFrontier(i))
+			fail("frontier cell", step, i);
+		++walked;
+	});
+	if (walked != frontierSize)
+		fail("frontier walk", step, 0);
+}
+
+// Plays the input on both, aborting on the first difference. Returns false if
+// the input does not make a board.
+bool check(std::span<const std::uint8_t> bytes, Trace* trace = nullptr)
+{
+	Reader reader(bytes);
+	Vec2s size = {1 + std::size_t(reader.read(1)) % MAX_SIDE, 1 + std::size_t(reader.read(1)) % MAX_SIDE};
+	std::size_t cellCount = size.x * size.y;
+	if (cellCount < 2)
+		return false;
+
+	std::size_t mineCount = std::size_t(reader.read(2)) % cellCount; // up to cellCount - 1
+	gen.seed(reader.read(8));
+
+	Board board;
+	board.setFrontierTracked(true);
+	board.resize(size);
+	board.setMineCount(mineCount);
+	board.placeMines();
+
+	std::vector<std::uint64_t> mined(Board::getLayerWordCount(size));
+	board.exportLayer(Board::Layer::Mined, mined);
+	std::size_t placed = 0;
+	for (const Cell& cell : board.getCells())
+		placed += cell.mined;
+	if (placed != mineCount)
+		fail("placeMines count", 0, 0);
+
+	Reference reference;
+	reference.reset(size, mined);
+	compare(board, reference, 0);
+
+	if (trace)
+		*trace = {.size = size, .mined = mined, .actions = {}};
+
+	for (std::size_t step = 1; !reader.done(); ++step)
+	{
+		Action action{.op = Op(reader.read(1) % OP_COUNT), .index = std::size_t(reader.read(2)) % cellCount, .destination = 0};
+		std::size_t index = action.index;
+		switch (action.op)
+		{
+		case Op::Open:
+			if (board.open(index) != reference.open(index))
+				fail("open result", step, index);
+			break;
+
+		case Op::Flag:
+			board.flag(index);
+			reference.flag(index);
+			break;
+
+		case Op::ChordAll:
+			if (board.chordAll() != reference.chordAll())
+				fail("chordAll result", step, 0);
+			break;
+
+		case Op::MakeSafe:
+		case Op::MoveMine:
+		{
+			bool wasMined = reference.isMined(index);
+			action.destination = action.op == Op::MakeSafe ? board.makeSafe(index) : board.moveMine(index);
+			if (action.destination == index)
+			{
+				// makeSafe always moves a mine, moveMine only fails when boxed in
+				if (wasMined && action.op == Op::MakeSafe)
+					fail("makeSafe left the mine", step, index);
+				break;
+			}
+
+			std::size_t destination = action.destination;
+			if (!wasMined || reference.isMined(destination))
+				fail("mine moved to a mined cell", step, destination);
+
+			if (action.op == Op::MoveMine)
+			{
+				bool isNeighbour = false;
+				reference.forEachNeighbour(index, [&](std::size_t n) { isNeighbour |= n == destination; });
+				if (!isNeighbour || reference.isOpened(destination))
+					fail("moveMine destination", step, destination);
+			}
+			reference.relocateMine(index, destination);
+		}
+		break;
+		}
+
+		compare(board, reference, step);
+		if (trace)
+			trace->actions.push_back(action);
+	}
+	return true;
+}
+
+struct Throughput
+{
+	double setupUs;       // per board
+	double actionsPerSec;
+};
+
+// Replays the traces on one implementation. Setting up a board is timed apart,
+// it depends on the mine count much more than on the actions.
+template <class Implementation>
+Throughput measure(const std::vector<Trace>& traces)
+{
+	using Clock = std::chrono::steady_clock;
+	Implementation implementation;
+	std::size_t actions = 0;
+	Clock::duration setupTime{}, actionTime{};
+	volatile std::size_t sink = 0; // keeps the work from being optimized away
+
+	for (const Trace& trace : traces)
+	{
+		auto start = Clock::now();
+		implementation.reset(trace.size, trace.mined);
+		auto setupEnd = Clock::now();
+
+		for (const Action& action : trace.actions)
+		{
+			switch (action.op)
+			{
+			case Op::Open: sink = sink + implementation.open(action.index); break;
+			case Op::Flag: implementation.flag(action.index); break;
+			case Op::ChordAll: sink = sink + implementation.chordAll(); break;
+			default:
+				if (action.destination != action.index)
+					implementation.relocateMine(action.index, action.destination);
+				break;
+			}
+		}
+		sink = sink + implementation.getOpenCount();
+
+		setupTime += setupEnd - start;
+		actionTime += Clock::now() - setupEnd;
+		actions += trace.actions.size();
+	}
+
+	return
+	{
+		.setupUs = std::chrono::duration<double, std::micro>(setupTime).count() / double(traces.size()),
+		.actionsPerSec = double(actions) / std::chrono::duration<double>(actionTime).count()
+	};
+}
+
+// The Board, behind the same interface as the reference
+struct BoardImplementation
+{
+	Board board;
+	std::vector<std::uint64_t> none;
+
+	void reset(const Vec2s& size, std::span<const std::uint64_t> mined)
+	{
+		none.assign(mined.size(), 0);
+		board.importLayers(size, mined, none, none);
+	}
+	bool open(std::size_t index) { return board.open(index); }
+	void flag(std::size_t index) { board.flag(index); }
+	bool chordAll() { return board.chordAll(); }
+	void relocateMine(std::size_t from, std::size_t to) { board.relocateMine(from, to); }
+	std::size_t getOpenCount() const { return board.getOpenCount(); }
+};
+
+// The same, keeping track of its frontier
+struct FrontierImplementation : BoardImplementation
+{
+	FrontierImplementation() { board.setFrontierTracked(true); }
+};
+
+bool parse(const char* arg, auto& value)
+{
+	std::string_view str(arg);
+	auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	return ec == std::errc{} && end == str.data() + str.size();
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+	check({data, size});
+	return 0;
+}
+
+#ifndef MPP_LIBFUZZER
+
+int main(int argc, char** argv)
+{
+	// Files are inputs to replay, a crash reproducer from a libFuzzer run for one
+	if (argc > 1 && std::filesystem::is_regular_file(argv[1]))
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::ifstream in(argv[i], std::ios::binary);
+			std::vector<std::uint8_t> bytes(std::istreambuf_iterator<char>(in), {});
+			check(bytes);
+			std::printf("%s: ok\n", argv[i]);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	std::size_t inputs = DEFAULT_INPUTS;
+	std::uint64_t seed = 0;
+	if (argc > 3 || (argc > 1 && !parse(argv[1], inputs)) || (argc > 2 && !parse(argv[2], seed)) || inputs == 0)
+	{
+		std::fprintf(stderr, "Usage: %s [inputs] [seed]\n", argv[0]);
+		std::fprintf(stderr, "       %s <input file>...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::mt19937_64 inputGen(seed); // apart from 'gen', which the Board draws from
+
+	std::vector<Trace> traces;
+	std::vector<std::uint8_t> bytes;
+	std::size_t actions = 0;
+	for (std::size_t i = 0; i < inputs; ++i)
+	{
+		bytes.resize(inputGen() % MAX_INPUT_SIZE);
+		for (auto& byte : bytes)
+			byte = std::uint8_t(inputGen());
+
+		Trace trace;
+		if (check(bytes, &trace))
+		{
+			actions += trace.actions.size();
+			traces.push_back(std::move(trace));
+		}
+	}
+	std::printf("%zu boards, %zu actions: no difference\n", traces.size(), actions);
+	if (traces.empty())
+	{
+		std::fprintf(stderr, "No input made a board, no throughput to measure\n");
+		return EXIT_FAILURE;
+	}
+
+	auto report = [](const char* name, Throughput throughput)
+	{
+		std::printf("%-10s: %7.2f us setup / board, %7.2f M actions/s\n", name, throughput.setupUs, throughput.actionsPerSec / 1e6);
+	};
+	report("board", measure<BoardImplementation>(traces));
+	report("frontier", measure<FrontierImplementation>(traces));
+	report("reference", measure<Reference>(traces));
+	return EXIT_SUCCESS;
+}
+
+#endif // MPP_LIBFUZZER
@@ -0,0 +1,233 @@
+#include "Game/Autosave.h"
+#include "Game/GameLogic.h"
+#include "Game/Replay.h"
+#include "Utils/MyRandom.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+ * Headless playback of recorded games, at full speed.
+ * Every replay is checked against its recorded outcome, then the whole set is
+ * played again and again for a second to measure the throughput.
+ * The check mode plays random games the way the game does, restarted on one
+ * thread and played on an other, with dense mines and running bombs so that
+ * first clicks move mines. Each game is then replayed from its seed alone, and
+ * recovered from its autosave, and both have to end on the same board, cell
+ * for cell, the recovery with the same running bombs.
+ * Usage: MineReplay <replay file or directory>...
+ *        MineReplay check [games] [seed]
+ */
+
+namespace
+{
+
+constexpr std::chrono::seconds BENCH_TIME{1};
+
+constexpr std::size_t DEFAULT_CHECK_GAMES = 1000;
+constexpr Vec2s CHECK_SIZE = {16, 16};
+constexpr std::size_t CHECK_MAX_ACTIONS = 200;
+
+struct Entry
+{
+	std::string name;
+	Replay replay;
+};
+
+void add(std::vector<Entry>& entries, const std::filesystem::path& file)
+{
+	Entry entry{.name = file.string(), .replay = {}};
+	if (entry.replay.load(file))
+		entries.push_back(std::move(entry));
+	else
+		std::fprintf(stderr, "%s: not a replay\n", entry.name.c_str());
+}
+
+// Plays random actions on 'game' until it is over, recorded into 'replay'.
+void playRandom(GameLogic& game, Replay& replay, std::mt19937_64& inputs)
+{
+	const Board& board = game.getBoard();
+	std::size_t cellCount = board.getCells().size();
+	for (std::size_t n = 0; n < CHECK_MAX_ACTIONS && !game.isGameOver(); ++n)
+	{
+		std::size_t index = std::size_t(randomBelow(inputs, cellCount));
+		if (game.getState() == GameLogic::Playing && randomBelow(inputs, 8) == 0)
+		{
+			if (game.flag(index))
+				replay.record(Replay::Flag, index, n);
+			continue;
+		}
+		Replay::Action action = board.getCellAt(index).opened ? Replay::Chord : Replay::Open;
+		if (game.open(index))
+			replay.record(action, index, n);
+	}
+}
+
+bool sameBoard(const Board& a, const Board& b)
+{
+	const auto& cellsA = a.getCells();
+	const auto& cellsB = b.getCells();
+	if (cellsA.size() != cellsB.size())
+		return false;
+	for (std::size_t i = 0; i < cellsA.size(); ++i)
+	{
+		const Cell& cellA = cellsA[i];
+		const Cell& cellB = cellsB[i];
+		if (cellA.mined != cellB.mined || cellA.opened != cellB.opened || cellA.flagged != cellB.flagged)
+			return false;
+	}
+	return true;
+}
+
+int check(std::size_t games, std::uint64_t seed)
+{
+	std::mt19937_64 inputs(seed);
+	std::size_t failures = 0, recoveryFailures = 0, firstClickMoves = 0, runningBombMoves = 0;
+
+	// Autosaved aside, not over the game's own
+	std::error_code error;
+	std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "MineReplayCheck";
+	std::filesystem::create_directories(directory, error);
+	std::filesystem::path snapshotFile = directory / Autosave::DEFAULT_SNAPSHOT;
+	std::filesystem::path journalFile = directory / Autosave::DEFAULT_JOURNAL;
+
+	for (std::size_t g = 0; g < games; ++g)
+	{
+		std::size_t mineCount = 40 + std::size_t(randomBelow(inputs, 120));
+		GameLogic game;
+		game.resize(CHECK_SIZE);
+		game.setMineCount(mineCount);
+		game.setRunningBombCount(std::size_t(randomBelow(inputs, 5)));
+
+		// As the game: restarted on this thread, played on the simulation's,
+		// autosaved from a snapshot taken before the first click
+		std::uint64_t gameSeed = mix(seed ^ mix(g));
+		Replay replay;
+		std::mt19937_64 gameInputs(inputs());
+		{
+			Autosave autosave(snapshotFile, journalFile);
+			game.setAutosave(&autosave);
+			game.restart(gameSeed);
+			replay.begin(gameSeed);
+			autosave.begin(game.takeSnapshot(),
+				{.state = game.getState(), .playingTimeUs = 0, .rotationSpeed = 0.f,
+				 .runningBombCount = game.getRunningBombCount(), .runningBombIndexes = {}, .sequence = 0, .gameId = 0});
+			std::thread([&] { playRandom(game, replay, gameInputs); }).join();
+			game.setAutosave(nullptr);
+		} // writes everything pending
+
+		const Board& board = game.getBoard();
+		replay.finish(
+			{.size = CHECK_SIZE, .mineCount = mineCount, .runningBombCount = game.getRunningBombIndexes().size()},
+			{.state = game.getState(), .openCount = board.getOpenCount(), .flagCount = board.getFlagCount()});
+		firstClickMoves += board.getCounters().makeSafeRelocations;
+		runningBombMoves += board.getCounters().moveMineSuccesses;
+
+		GameLogic replayed;
+		if (!replay.play(replayed) || !sameBoard(board, replayed.getBoard()))
+		{
+			std::printf("game %zu (seed %llu): diverged\n", g, (unsigned long long)gameSeed);
+			++failures;
+		}
+
+		Board recovered;
+		SaveFile::Meta meta;
+		bool mineOpened;
+		if (!Autosave(snapshotFile, journalFile).recover(recovered, meta, mineOpened)
+		    || !sameBoard(board, recovered)
+		    || meta.runningBombIndexes != game.getRunningBombIndexes())
+		{
+			std::printf("game %zu (seed %llu): recovered another game\n", g, (unsigned long long)gameSeed);
+			++recoveryFailures;
+		}
+	}
+	std::filesystem::remove_all(directory, error);
+
+	std::printf("games              : %zu (%zu diverged, %zu recovered wrong)\n", games, failures, recoveryFailures);
+	std::printf("first click moves  : %zu\n", firstClickMoves);
+	std::printf("running bomb moves : %zu\n", runningBombMoves);
+	// A check that moved no mine checked nothing
+	if (games && (!firstClickMoves || !runningBombMoves))
+	{
+		std::fprintf(stderr, "No mine moved, nothing checked\n");
+		return EXIT_FAILURE;
+	}
+	return failures || recoveryFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "Usage: %s <replay file or directory>...\n", argv[0]);
+		std::fprintf(stderr, "       %s check [games] [seed]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (std::string_view(argv[1]) == "check")
+	{
+		std::size_t games = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : DEFAULT_CHECK_GAMES;
+		std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+		return check(games, seed);
+	}
+
+	// Everything is loaded up front, only playback is measured
+	std::vector<Entry> entries;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_directory(argv[i], error))
+		{
+			add(entries, argv[i]);
+			continue;
+		}
+
+		for (auto& file : std::filesystem::directory_iterator(argv[i], error))
+			if (file.path().extension() == Replay::EXTENSION)
+				add(entries, file.path());
+	}
+
+	if (entries.empty())
+	{
+		std::fprintf(stderr, "No replay to play\n");
+		return EXIT_FAILURE;
+	}
+
+	GameLogic game;
+	std::size_t failures = 0, events = 0;
+	for (auto& entry : entries)
+	{
+		events += entry.replay.getEventCount();
+		if (!entry.replay.play(game))
+		{
+			std::printf("%s: diverged\n", entry.name.c_str());
+			++failures;
+		}
+	}
+
+	std::size_t games = 0;
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed{};
+	while (elapsed < BENCH_TIME)
+	{
+		for (auto& entry : entries)
+			entry.replay.play(game);
+		games += entries.size();
+		elapsed = std::chrono::steady_clock::now() - start;
+	}
+
+	double seconds = elapsed.count();
+	double rounds = double(games) / double(entries.size());
+	std::printf("replays        : %zu (%zu diverged)\n", entries.size(), failures);
+	std::printf("events         : %zu\n", events);
+	std::printf("time / replay  : %.3f us\n", seconds / double(games) * 1e6);
+	std::printf("throughput     : %.0f replays/s, %.0f events/s\n", double(games) / seconds, rounds * double(events) / seconds);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
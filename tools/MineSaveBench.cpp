@@ -0,0 +1,156 @@
+#include "Game/Autosave.h"
+#include "Game/SaveFile.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string_view>
+
+/*
+ * Save and load throughput on a board in mid-game, then the cost of the
+ * autosave journal as seen by the game.
+ * Usage: MineSaveBench <width> <height> <mines> [file]
+ */
+
+namespace
+{
+
+constexpr int REPEATS = 3;
+
+bool parse(const char* arg, auto& value)
+{
+	std::string_view str(arg);
+	auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	return ec == std::errc{} && end == str.data() + str.size();
+}
+
+// Best of a few runs, in seconds
+template <class F>
+double measure(F&& f)
+{
+	double best = 1e300;
+	for (int i = 0; i < REPEATS; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (!f())
+			return -1.0;
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+void report(const char* name, double seconds, std::size_t cells, std::uintmax_t bytes)
+{
+	if (seconds < 0.0)
+	{
+		std::printf("%-16s: failed\n", name);
+		return;
+	}
+	std::printf("%-16s: %9.3f ms  %9.1f Mcells/s  %9.1f MB/s\n",
+	            name, seconds * 1e3, double(cells) / seconds / 1e6, double(bytes) / seconds / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	Vec2s size;
+	std::size_t mines;
+	if (argc < 4 || argc > 5 || !parse(argv[1], size.x) || !parse(argv[2], size.y) || !parse(argv[3], mines))
+	{
+		std::fprintf(stderr, "Usage: %s <width> <height> <mines> [file]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::filesystem::path file = argc > 4 ? argv[4] : "bench.mpp";
+
+	if (!Board::isSizeValid(size) || mines >= size.x * size.y)
+	{
+		std::fprintf(stderr, "Invalid board: %zux%zu with %zu mines\n", size.x, size.y, mines);
+		return EXIT_FAILURE;
+	}
+
+	// A game in progress: a first cascade and a few flags
+	Board board;
+	board.resize(size);
+	board.setMineCount(mines);
+	board.placeMines();
+	std::size_t center = board.toIndex({size.x / 2, size.y / 2});
+	board.makeSafe(center);
+	board.open(center);
+	for (std::size_t i = 0; i < board.getCells().size(); i += 97)
+		if (board.getCellAt(i).mined)
+			board.flag(i);
+
+	std::size_t cells = size.x * size.y;
+	SaveFile::Meta meta{.state = 2, .playingTimeUs = 0, .rotationSpeed = 0.f, .runningBombCount = 0, .runningBombIndexes = {}, .sequence = 0, .gameId = 0};
+	Board loaded;
+	SaveFile::Meta loadedMeta;
+
+	std::printf("board %zux%zu, %zu mines, %zu opened, %zu flagged\n",
+	            size.x, size.y, mines, board.getOpenCount(), board.getFlagCount());
+
+	for (bool compress : {false, true})
+	{
+		double save = measure([&] { return SaveFile::save(file, board, meta, compress); });
+		std::uintmax_t bytes = std::filesystem::file_size(file);
+		double load = measure([&] { return SaveFile::load(file, loaded, loadedMeta); });
+
+		std::printf("%s: %ju bytes (%.3f bits per cell)\n",
+		            compress ? "run-length" : "raw", bytes, double(bytes) * 8.0 / double(cells));
+		report("  save", save, cells, bytes);
+		report("  load", load, cells, bytes);
+	}
+
+	std::filesystem::remove(file);
+
+	// Records only touch memory. The first snapshot copies the board, the next
+	// ones only the chunks written to in between: here, a single flag.
+	std::filesystem::path snapshotFile = file, journalFile = file;
+	snapshotFile += ".autosave";
+	journalFile += ".log";
+	{
+		using Clock = std::chrono::steady_clock;
+		auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+		auto start = Clock::now();
+		[[maybe_unused]] Board copy = board;
+		auto copyEnd = Clock::now();
+
+		Autosave autosave(snapshotFile, journalFile);
+		auto firstStart = Clock::now();
+		autosave.begin(board.takeSnapshot(), meta);
+		auto firstEnd = Clock::now();
+
+		std::size_t closed = 0;
+		while (board.getCellAt(closed).opened)
+			++closed;
+		board.flag(closed);
+		auto nextStart = Clock::now();
+		autosave.snapshot(board.takeSnapshot(), meta);
+		auto nextEnd = Clock::now();
+
+		for (std::size_t i = 0; i < cells; i += 7)
+			autosave.flag(i);
+
+		const auto& stats = autosave.getStats();
+		std::printf("autosave: %ju records, %.1f ns avg, %.1f us max\n",
+		            std::uintmax_t(stats.records),
+		            double(stats.recordTime.count()) / double(stats.records),
+		            double(stats.maxRecordTime.count()) / 1e3);
+		std::printf("  board copy %.3f ms, first snapshot %.3f ms, next snapshot %.3f ms (%zu cells)\n",
+		            ms(copyEnd - start), ms(firstEnd - firstStart), ms(nextEnd - nextStart), cells);
+	}
+	Board recovered;
+	SaveFile::Meta recoveredMeta;
+	bool mineOpened;
+	double recover = measure([&] { return Autosave(snapshotFile, journalFile).recover(recovered, recoveredMeta, mineOpened); });
+	std::printf("  recovered %ju records\n", std::uintmax_t(recoveredMeta.sequence));
+	report("  recover", recover, cells, std::filesystem::file_size(journalFile));
+
+	std::filesystem::remove(snapshotFile);
+	std::filesystem::remove(journalFile);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include "Sim/Simulation.h"
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+/*
+ * Headless Monte-Carlo simulation.
+ * Usage: MineSim <width> <height> <mines> [games] [threads] [seed]
+ */
+
+namespace
+{
+
+bool parse(const char* arg, auto& value)
+{
+	std::string_view str(arg);
+	auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	return ec == std::errc{} && end == str.data() + str.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	SimulationParams params
+	{
+		.size = {},
+		.mineCount = 0,
+		.games = 100'000,
+		.threads = 0,
+		.seed = 0
+	};
+
+	bool valid = argc >= 4 && argc <= 7
+	             && parse(argv[1], params.size.x)
+	             && parse(argv[2], params.size.y)
+	             && parse(argv[3], params.mineCount)
+	             && (argc <= 4 || parse(argv[4], params.games))
+	             && (argc <= 5 || parse(argv[5], params.threads))
+	             && (argc <= 6 || parse(argv[6], params.seed));
+
+	if (!valid)
+	{
+		std::fprintf(stderr, "Usage: %s <width> <height> <mines> [games] [threads] [seed]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!Board::isSizeValid(params.size) || params.mineCount >= params.size.x * params.size.y)
+	{
+		std::fprintf(stderr, "Invalid board: %zux%zu with %zu mines\n", params.size.x, params.size.y, params.mineCount);
+		return EXIT_FAILURE;
+	}
+
+	auto result = simulate(params);
+	double seconds = double(result.wallTime.count()) / 1e9;
+
+	std::printf("board          : %zux%zu, %zu mines\n", params.size.x, params.size.y, params.mineCount);
+	std::printf("games          : %zu\n", result.games);
+	std::printf("win rate       : %.4f\n", result.winRate());
+	std::printf("guesses / game : %.4f\n", result.guessesPerGame());
+	std::printf("time / game    : %.3f us\n", result.nanosecondsPerGame() / 1e3);
+	std::printf("wall time      : %.3f s (%.0f games/s)\n", seconds, seconds > 0.0 ? double(result.games) / seconds : 0.0);
+
+	const auto& counters = result.counters;
+	auto perGame = [&](std::uint64_t count) { return result.games ? double(count) / double(result.games) : 0.0; };
+	std::printf("opens / game   : %.2f (%.2f cells each, %ju max)\n",
+	            perGame(counters.openCalls),
+	            counters.openCalls ? double(counters.cellsOpened) / double(counters.openCalls) : 0.0,
+	            std::uintmax_t(counters.maxCellsPerOpen));
+	std::printf("seed stack     : %ju peak, %.4f spills / game\n",
+	            std::uintmax_t(counters.seedStackPeak), perGame(counters.seedStackSpills));
+	std::printf("scan pushes    : %.2f / game\n", perGame(counters.scanRowPushes));
+	std::printf("mine moves     : %.2f / game, %.4f failed, %.4f first click\n",
+	            perGame(counters.moveMineSuccesses), perGame(counters.moveMineFailures), perGame(counters.makeSafeRelocations));
+	return EXIT_SUCCESS;
+}
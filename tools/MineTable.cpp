@@ -0,0 +1,87 @@
+#include "Sim/DifficultyTable.h"
+#include "Sim/Simulation.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+/*
+ * Rebuilds the difficulty table by simulation.
+ * Usage: MineTable [output] [games per entry] [threads] [seed]
+ */
+
+namespace
+{
+
+constexpr float SIDES[] = {4, 6, 8, 12, 16, 24, 32, 48, 64};
+constexpr std::size_t DENSITY_COUNT = 16;
+constexpr float DENSITY_STEP = 0.02f; // 0% through 30%
+
+bool parse(const char* arg, auto& value)
+{
+	std::string_view str(arg);
+	auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	return ec == std::errc{} && end == str.data() + str.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	const char* output = "res/difficulty.bin";
+	std::size_t games = 2000;
+	unsigned threads = 0;
+	std::uint64_t seed = 0;
+
+	// An output starting with a dash is an option, --help most likely, never a file
+	bool valid = argc <= 5
+	             && (argc <= 1 || argv[1][0] != '-')
+	             && (argc <= 2 || parse(argv[2], games))
+	             && (argc <= 3 || parse(argv[3], threads))
+	             && (argc <= 4 || parse(argv[4], seed));
+	if (!valid)
+	{
+		std::fprintf(stderr, "Usage: %s [output] [games per entry] [threads] [seed]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc > 1)
+		output = argv[1];
+
+	std::vector<float> densities(DENSITY_COUNT);
+	for (std::size_t d = 0; d < DENSITY_COUNT; ++d)
+		densities[d] = float(d) * DENSITY_STEP;
+
+	constexpr std::size_t sideCount = std::size(SIDES);
+	std::vector<float> winRates(sideCount * sideCount * DENSITY_COUNT);
+	auto at = [&](std::size_t a, std::size_t b, std::size_t d) -> float&
+	{
+		return winRates[(a * sideCount + b) * DENSITY_COUNT + d];
+	};
+
+	// Each entry is simulated on every core, the table is symmetric in its sides
+	for (std::size_t a = 0; a < sideCount; ++a)
+	{
+		for (std::size_t b = a; b < sideCount; ++b)
+		{
+			Vec2s size = {std::size_t(SIDES[a]), std::size_t(SIDES[b])};
+			std::size_t cells = size.x * size.y;
+			for (std::size_t d = 0; d < DENSITY_COUNT; ++d)
+			{
+				std::size_t mines = std::min(std::size_t(std::lround(densities[d] * float(cells))), cells - 1);
+				auto result = simulate({.size = size, .mineCount = mines, .games = games, .threads = threads, .seed = seed});
+				at(a, b, d) = at(b, a, d) = float(result.winRate());
+			}
+			std::printf("%zux%zu done\n", size.x, size.y);
+		}
+	}
+
+	if (!DifficultyTable::write(output, SIDES, densities, winRates))
+	{
+		std::fprintf(stderr, "Could not write %s\n", output);
+		return EXIT_FAILURE;
+	}
+	std::printf("Written to %s\n", output);
+	return EXIT_SUCCESS;
+}